@@ -0,0 +1,1255 @@
+/* +------------------------------------------------------+
+ * | strsepf.c                                            |
+ * | String parsing utilities combining the memory safety |
+ * | of strsep the convenience of a sscanf-like           |
+ * | interface.                                           |
+ * |                                                      |
+ * +------------------------------------------------------+
+ * |                                        G. Berthiaume |
+ * |                                          MIT licence |
+ * |                                                 2019 |
+ * +------------------------------------------------------+
+ */
+#include "strsepf.h"
+
+//-------------------------------------------//
+//                                           //
+//                Includes                   //
+//                                           //
+//-------------------------------------------//
+#include <ctype.h>  //< cstdlib : isdigit
+#include <errno.h>  //< cstdlib : For strtol_s
+#include <stdlib.h> //< cstdlib : strtol
+#include <string.h> //< cstdlib : strchr, memchr
+
+#include "strsepf_simd.h"
+
+#ifdef STRSEPF_PROFILE
+#include "strsepf_profile.h"
+#endif
+
+//-------------------------------------------//
+//                                           //
+//          Internal definitions             //
+//                                           //
+//-------------------------------------------//
+
+// Profiling hooks: the time since the last hook is attributed to the previous stage.
+#ifdef STRSEPF_PROFILE
+#define STRSEPF_PROFILE_STAGE(stage) strsepf_profile_mark_(stage)
+#define STRSEPF_PROFILE_IDLE()       strsepf_profile_mark_(STRSEPF_STAGE_COUNT)
+#else
+#define STRSEPF_PROFILE_STAGE(stage) ((void)0)
+#define STRSEPF_PROFILE_IDLE()       ((void)0)
+#endif
+
+// Maximum number of arguments (arrays and predicates) of a repeated group.
+#ifndef STRSEPF_GROUP_MAX_ARGS
+#define STRSEPF_GROUP_MAX_ARGS 16
+#endif
+
+/*
+ * A decoded format specifier: [=%[*][?][width][modifiers]type=]
+ */
+typedef struct
+{
+    char     type;
+    bool     noAssign;
+    bool     predicate;
+    uint32_t width;
+} strsepf_specifier_;
+
+/*
+ * An argument fetched ahead of the parsing by the repeated groups and the
+ * key/value formats.
+ */
+typedef union
+{
+    strsepf_predicate const* predicate;
+    strsepf_intern*          intern;
+    char**                   strs;
+    uint32_t*                u32s;
+    int32_t*                 i32s;
+} strsepf_arg_;
+
+/*
+ * Parsing state shared by `vstrsepf` and the repeated groups.
+ */
+typedef struct
+{
+    char*               mutStr;    //< Remaining input (NULL when exhausted)
+    va_list*            arg;       //< Arguments of the top level format
+    strsepf_arg_ const* groupArgs; //< Group arguments (NULL outside a group)
+    size_t              groupArg;  //< Next group argument
+    size_t              index;     //< Current repetition of the group
+    char                stop;      //< Character ending the group ('\0' if none)
+    bool                stopped;   //< The group stop character was found
+    strsepf_arena*      arena;     //< Receives copies of the `%s` tokens (NULL: no copy)
+    char*               field;     //< Input of the current field, for the diagnostics
+    char const*         fieldFmt;  //< Format of the current field, for the diagnostics
+    char*               cut;       //< Last delimiter replaced by '\0'
+    char                cutChar;   //< Delimiter replaced at `cut`
+} strsepf_state_;
+
+static int16_t
+strsepf_parse_(strsepf_state_* state, char const** fmtp, char const* fmtEnd);
+
+static int16_t
+strsepf_parse_group_(strsepf_state_* state, char const** fmtp, char const* fmtEnd);
+
+static strsepf_result
+strsepf_decode_specifier_(char const** fmtp, char const* fmtEnd, strsepf_specifier_* spec);
+
+static uint8_t
+strsepf_base_(char type);
+
+static bool
+strsepf_predicate_fits_(strsepf_predicate const* predicate, char type);
+
+static uint32_t
+strsepf_hash_init_(uint32_t seed);
+
+static uint32_t
+strsepf_hash_step_(uint32_t hash, char c);
+
+static uint32_t
+strsepf_hash_(char const* key, size_t len, uint32_t seed);
+
+static char*
+strsepf_arena_copy_(strsepf_arena* arena, char const* str);
+
+static strsepf_result
+strsepf_store_str_(strsepf_state_* state, char* token, char** ptr);
+
+static strsepf_predicate const*
+strsepf_next_predicate_(strsepf_state_* state);
+
+static strsepf_intern*
+strsepf_next_intern_(strsepf_state_* state);
+
+static char**
+strsepf_next_str_(strsepf_state_* state);
+
+static uint32_t*
+strsepf_next_u32_(strsepf_state_* state);
+
+static int32_t*
+strsepf_next_i32_(strsepf_state_* state);
+
+//-------------------------------------------//
+//                                           //
+//              Implementation               //
+//                                           //
+//-------------------------------------------//
+
+int16_t
+strsepf(char mutStr[], char const* fmt, ...)
+{
+    int16_t rc;
+    va_list arg;
+    va_start(arg, fmt);
+    rc = vstrsepf(mutStr, fmt, arg);
+    va_end(arg);
+    return rc;
+}
+
+int16_t
+vstrsepf(char mutStr[], char const* fmt, va_list arg)
+{
+    if (mutStr == NULL || fmt == NULL) {
+        return STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+    }
+
+    va_list args;
+    va_copy(args, arg); //< Passed by pointer to the internal functions
+
+    strsepf_state_ state = { .mutStr = mutStr, .arg = &args };
+    int16_t        rc = strsepf_parse_(&state, &fmt, fmt + strlen(fmt));
+    STRSEPF_PROFILE_IDLE();
+    va_end(args);
+    return rc;
+}
+
+int16_t
+strsepf_copy(strsepf_arena* arena, char mutStr[], char const* fmt, ...)
+{
+    int16_t rc;
+    va_list arg;
+    va_start(arg, fmt);
+    rc = vstrsepf_copy(arena, mutStr, fmt, arg);
+    va_end(arg);
+    return rc;
+}
+
+int16_t
+vstrsepf_copy(strsepf_arena* arena, char mutStr[], char const* fmt, va_list arg)
+{
+    if (arena == NULL || arena->base == NULL || mutStr == NULL || fmt == NULL) {
+        return STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+    }
+
+    va_list args;
+    va_copy(args, arg); //< Passed by pointer to the internal functions
+
+    size_t const   used = arena->used;
+    strsepf_state_ state = { .mutStr = mutStr, .arg = &args, .arena = arena };
+    int16_t        rc = strsepf_parse_(&state, &fmt, fmt + strlen(fmt));
+    STRSEPF_PROFILE_IDLE();
+    va_end(args);
+
+    if (rc < STRSEPF_RESULT_OK) {
+        arena->used = used; //< Release the copies of a failed parsing
+    }
+    return rc;
+}
+
+int16_t
+strsepf_diag(strsepf_error_info* info, char const* resync, char mutStr[], char const* fmt, ...)
+{
+    int16_t rc;
+    va_list arg;
+    va_start(arg, fmt);
+    rc = vstrsepf_diag(info, resync, mutStr, fmt, arg);
+    va_end(arg);
+    return rc;
+}
+
+int16_t
+vstrsepf_diag(strsepf_error_info* info,
+              char const*         resync,
+              char                mutStr[],
+              char const*         fmt,
+              va_list             arg)
+{
+    if (info == NULL || mutStr == NULL || fmt == NULL) {
+        return STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+    }
+
+    va_list args;
+    va_copy(args, arg); //< Passed by pointer to the internal functions
+
+    char const*    fmtStart = fmt;
+    strsepf_state_ state = { .mutStr = mutStr, .arg = &args, .field = mutStr, .fieldFmt = fmt };
+    int16_t        rc = strsepf_parse_(&state, &fmt, fmt + strlen(fmt));
+    STRSEPF_PROFILE_IDLE();
+    va_end(args);
+
+    info->result = rc;
+    info->inputOffset = 0;
+    info->formatOffset = 0;
+    info->resync = NULL;
+    if (rc >= STRSEPF_RESULT_OK) {
+        return rc;
+    }
+
+    info->inputOffset = (size_t)(state.field - mutStr);
+    info->formatOffset = (size_t)(state.fieldFmt - fmtStart);
+
+    // Put back the delimiter of the failed token: the next record may start there
+    if (state.cut != NULL && state.cut >= state.field) {
+        *state.cut = state.cutChar;
+    }
+
+    // Next record start, never the record that just failed
+    char* from = (state.field > mutStr || *mutStr == '\0') ? state.field : mutStr + 1;
+    char* found = strsepf_scan_(from, resync != NULL ? resync : STRSEPF_RESYNC_DEFAULT);
+    if (*found != '\0') {
+        info->resync = (*found == '\n' || *found == '\r') ? found + 1 : found;
+    }
+    return rc;
+}
+
+void
+strsepf_arena_init(strsepf_arena* arena, char memory[], size_t cap)
+{
+    if (arena == NULL) {
+        return;
+    }
+    arena->base = memory;
+    arena->cap = (memory == NULL) ? 0 : cap;
+    arena->used = 0;
+}
+
+void
+strsepf_arena_reset(strsepf_arena* arena)
+{
+    if (arena != NULL) {
+        arena->used = 0;
+    }
+}
+
+int16_t
+strsepf_intern_init(strsepf_intern* intern,
+                    uint32_t        slots[],
+                    char const*     strs[],
+                    size_t          nSlots,
+                    char            memory[],
+                    size_t          cap)
+{
+    if (intern == NULL || slots == NULL || strs == NULL || memory == NULL || nSlots < 2 ||
+        nSlots > (UINT32_MAX / 4 + 1) || (nSlots & (nSlots - 1)) != 0) {
+        return STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+    }
+
+    memset(slots, 0, nSlots * sizeof(slots[0]));
+    intern->slots = slots;
+    intern->strs = strs;
+    intern->mask = (uint32_t)(nSlots - 1);
+    intern->maxIds = (uint32_t)(nSlots / 4 * 3 + (nSlots == 2)); //< Always an empty slot
+    intern->nIds = 0;
+    strsepf_arena_init(&intern->arena, memory, cap);
+    return STRSEPF_RESULT_OK;
+}
+
+int32_t
+strsepf_intern_id(strsepf_intern* intern, char const* str)
+{
+    if (intern == NULL || intern->slots == NULL || str == NULL) {
+        return STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+    }
+
+    // Linear probing, until the string or an empty slot
+    size_t const len = strlen(str);
+    uint32_t     i = strsepf_hash_(str, len, 0) & intern->mask;
+    for (; intern->slots[i] != 0; i = (i + 1) & intern->mask) {
+        char const* const interned = intern->strs[intern->slots[i] - 1];
+        if (strcmp(interned, str) == 0) {
+            return (int32_t)(intern->slots[i] - 1);
+        }
+    }
+
+    if (intern->nIds == intern->maxIds) {
+        return STRSEPF_RESULT_ERR_INTERN_FULL;
+    }
+    char const* const copy = strsepf_arena_copy_(&intern->arena, str);
+    if (copy == NULL) {
+        return STRSEPF_RESULT_ERR_ARENA_FULL;
+    }
+    intern->strs[intern->nIds] = copy;
+    intern->slots[i] = ++intern->nIds;
+    return (int32_t)(intern->nIds - 1);
+}
+
+char const*
+strsepf_intern_str(strsepf_intern const* intern, uint32_t id)
+{
+    if (intern == NULL || id >= intern->nIds) {
+        return NULL;
+    }
+    return intern->strs[id];
+}
+
+int16_t
+strsepf_kv_compile(strsepf_kv* kv, char const* fmt)
+{
+    if (kv == NULL || fmt == NULL) {
+        return STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+    }
+    memset(kv, 0, sizeof(*kv));
+
+    char const* const fmtEnd = fmt + strlen(fmt);
+    while (fmt < fmtEnd) {
+        if (kv->nKeys == STRSEPF_KV_MAX_KEYS) {
+            return STRSEPF_RESULT_ERR_INVALID_FORMAT; //< Too many keys
+        }
+
+        // Key and key/value separator
+        char const* percent = memchr(fmt, '%', (size_t)(fmtEnd - fmt));
+        if (percent == NULL || percent - fmt < 2 || percent - fmt - 1 > UINT8_MAX) {
+            return STRSEPF_RESULT_ERR_INVALID_FORMAT; //< A key shall be followed by a specifier
+        }
+        if (kv->kvSep == '\0') {
+            kv->kvSep = percent[-1];
+        } else if (kv->kvSep != percent[-1]) {
+            return STRSEPF_RESULT_ERR_INVALID_FORMAT;
+        }
+
+        uint8_t const index = kv->nKeys;
+        kv->keys[index].name = fmt;
+        kv->keys[index].len = (uint8_t)(percent - fmt - 1);
+
+        // Specifier
+        strsepf_specifier_ spec;
+        fmt = percent + 1;
+        strsepf_result rc = strsepf_decode_specifier_(&fmt, fmtEnd, &spec);
+        if (rc < STRSEPF_RESULT_OK) {
+            return rc;
+        }
+        kv->keys[index].type = spec.type;
+        kv->keys[index].noAssign = spec.noAssign;
+        kv->keys[index].predicate = spec.predicate;
+        kv->keys[index].width = spec.width;
+
+        // Pair separator
+        if (fmt < fmtEnd) {
+            if (kv->pairSep == '\0') {
+                kv->pairSep = *fmt;
+            } else if (kv->pairSep != *fmt) {
+                return STRSEPF_RESULT_ERR_INVALID_FORMAT;
+            }
+            fmt++;
+        }
+        kv->nKeys++;
+    }
+    if (kv->nKeys == 0) {
+        return STRSEPF_RESULT_ERR_INVALID_FORMAT;
+    }
+    if (kv->pairSep == '\0') {
+        kv->pairSep = ' '; //< A single key: default separator
+    }
+    if (kv->pairSep == kv->kvSep) {
+        return STRSEPF_RESULT_ERR_INVALID_FORMAT;
+    }
+
+    // Keys shall be unique and shall not contain a separator
+    for (uint8_t i = 0; i < kv->nKeys; i++) {
+        if (memchr(kv->keys[i].name, kv->pairSep, kv->keys[i].len) != NULL ||
+            memchr(kv->keys[i].name, kv->kvSep, kv->keys[i].len) != NULL) {
+            return STRSEPF_RESULT_ERR_INVALID_FORMAT;
+        }
+        for (uint8_t j = 0; j < i; j++) {
+            if (kv->keys[i].len == kv->keys[j].len &&
+                memcmp(kv->keys[i].name, kv->keys[j].name, kv->keys[i].len) == 0) {
+                return STRSEPF_RESULT_ERR_INVALID_FORMAT;
+            }
+        }
+    }
+
+    // Perfect hash: search a seed without collisions, growing the table if needed.
+    size_t size = 2;
+    while (size < 2u * kv->nKeys) {
+        size *= 2;
+    }
+    for (; size <= STRSEPF_KV_TABLE_SIZE; size *= 2) {
+        for (uint32_t seed = 0; seed < 4096; seed++) {
+            memset(kv->table, 0, sizeof(kv->table));
+
+            uint8_t i;
+            for (i = 0; i < kv->nKeys; i++) {
+                uint32_t slot =
+                  strsepf_hash_(kv->keys[i].name, kv->keys[i].len, seed) & (uint32_t)(size - 1);
+                if (kv->table[slot] != 0) {
+                    break; //< Collision
+                }
+                kv->table[slot] = (uint8_t)(i + 1);
+            }
+            if (i == kv->nKeys) {
+                kv->seed = seed;
+                kv->tableMask = (uint8_t)(size - 1);
+                return kv->nKeys;
+            }
+        }
+    }
+    return STRSEPF_RESULT_ERR_INVALID_FORMAT; //< No perfect hash found
+}
+
+int16_t
+strsepf_kv_parse(strsepf_kv const* kv, char mutStr[], ...)
+{
+    int16_t rc;
+    va_list arg;
+    va_start(arg, mutStr);
+    rc = vstrsepf_kv_parse(kv, mutStr, arg);
+    va_end(arg);
+    return rc;
+}
+
+int16_t
+vstrsepf_kv_parse(strsepf_kv const* kv, char mutStr[], va_list arg)
+{
+    if (kv == NULL || mutStr == NULL || kv->nKeys == 0) {
+        return STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+    }
+
+    // Fetch the arguments in the order of the format
+    strsepf_arg_ predicates[STRSEPF_KV_MAX_KEYS];
+    strsepf_arg_ interns[STRSEPF_KV_MAX_KEYS];
+    strsepf_arg_ outputs[STRSEPF_KV_MAX_KEYS];
+    for (uint8_t i = 0; i < kv->nKeys; i++) {
+        predicates[i].predicate = NULL;
+        interns[i].intern = NULL;
+        outputs[i].strs = NULL;
+        if (kv->keys[i].predicate) {
+            predicates[i].predicate = va_arg(arg, strsepf_predicate const*);
+            if (predicates[i].predicate == NULL ||
+                !strsepf_predicate_fits_(predicates[i].predicate, kv->keys[i].type)) {
+                return STRSEPF_RESULT_ERR_INVALID_ARGS;
+            }
+        }
+        if (kv->keys[i].noAssign) {
+            continue;
+        }
+        if (kv->keys[i].type == 'k') {
+            interns[i].intern = va_arg(arg, strsepf_intern*);
+            if (interns[i].intern == NULL) {
+                return STRSEPF_RESULT_ERR_INVALID_ARGS;
+            }
+        }
+        bool isNull;
+        if (kv->keys[i].type == 's') {
+            outputs[i].strs = va_arg(arg, char**);
+            isNull = (outputs[i].strs == NULL);
+        } else if (strchr("uxobk", kv->keys[i].type) != NULL) {
+            outputs[i].u32s = va_arg(arg, uint32_t*);
+            isNull = (outputs[i].u32s == NULL);
+        } else {
+            outputs[i].i32s = va_arg(arg, int32_t*);
+            isNull = (outputs[i].i32s == NULL);
+        }
+        if (isNull) {
+            return STRSEPF_RESULT_ERR_INVALID_ARGS;
+        }
+    }
+
+    char const delim[] = { kv->pairSep, '\0' };
+    bool       seen[STRSEPF_KV_MAX_KEYS] = { false };
+    int        count = 0;
+    while (mutStr != NULL && *mutStr) {
+
+        // Hash the key while looking for its end
+        char*    key = mutStr;
+        uint32_t hash = strsepf_hash_init_(kv->seed);
+        for (; *mutStr != '\0' && *mutStr != kv->kvSep && *mutStr != kv->pairSep; mutStr++) {
+            hash = strsepf_hash_step_(hash, *mutStr);
+        }
+        size_t const keyLen = (size_t)(mutStr - key);
+        if (*mutStr != kv->kvSep) {
+            if (*mutStr == kv->pairSep) {
+                mutStr++; //< Token without a value
+            }
+            continue;
+        }
+        mutStr++;
+
+        uint8_t const slot = kv->table[hash & kv->tableMask];
+        if (slot == 0 || kv->keys[slot - 1].len != keyLen ||
+            memcmp(kv->keys[slot - 1].name, key, keyLen) != 0) {
+            char* next = strsepf_scan_(mutStr, delim); //< Unknown key
+            mutStr = (*next == '\0') ? NULL : next + 1;
+            continue;
+        }
+
+        uint8_t const i = (uint8_t)(slot - 1);
+        char*         token = strsepf_tokenize_(&mutStr, delim);
+
+        // Optinal specifier logic
+        strsepf_predicate const* predicate = predicates[i].predicate;
+        if (kv->keys[i].noAssign && predicate == NULL) {
+            continue; //< ignore it.
+        }
+        if (kv->keys[i].width > 0 && kv->keys[i].width < strlen(token)) {
+            return STRSEPF_RESULT_ERR_TOKEN_IS_BIGGER_THAN_WIDTH;
+        }
+
+        strsepf_result strtolErr = STRSEPF_RESULT_OK;
+        if (kv->keys[i].type == 's') {
+            if (predicate != NULL && !strsepf_predicate_string(predicate, token)) {
+                return STRSEPF_RESULT_ERR_PREDICATE_REJECTED;
+            }
+            if (!kv->keys[i].noAssign) {
+                *outputs[i].strs = token;
+            }
+        } else if (kv->keys[i].type == 'k') {
+            if (predicate != NULL && !strsepf_predicate_string(predicate, token)) {
+                return STRSEPF_RESULT_ERR_PREDICATE_REJECTED;
+            }
+            if (!kv->keys[i].noAssign) {
+                int32_t const id = strsepf_intern_id(interns[i].intern, token);
+                if (id < STRSEPF_RESULT_OK) {
+                    return (int16_t)id;
+                }
+                *outputs[i].u32s = (uint32_t)id;
+            }
+        } else if (strchr("uxob", kv->keys[i].type) != NULL) {
+            uint32_t value = strtou32_s(token, strsepf_base_(kv->keys[i].type), &strtolErr);
+            if (strtolErr < STRSEPF_RESULT_OK) {
+                return strtolErr;
+            }
+            if (predicate != NULL && !strsepf_predicate_number(predicate, value)) {
+                return STRSEPF_RESULT_ERR_PREDICATE_REJECTED;
+            }
+            if (!kv->keys[i].noAssign) {
+                *outputs[i].u32s = value;
+            }
+        } else {
+            int32_t value = strto32_s(token, strsepf_base_(kv->keys[i].type), &strtolErr);
+            if (strtolErr < STRSEPF_RESULT_OK) {
+                return strtolErr;
+            }
+            if (predicate != NULL && !strsepf_predicate_number(predicate, value)) {
+                return STRSEPF_RESULT_ERR_PREDICATE_REJECTED;
+            }
+            if (!kv->keys[i].noAssign) {
+                *outputs[i].i32s = value;
+            }
+        }
+
+        if (!kv->keys[i].noAssign && !seen[i]) {
+            seen[i] = true;
+            count++;
+        }
+    }
+    return count;
+}
+
+//-------------------------------------------//
+//                                           //
+//    Internal functions Implemetation       //
+//                                           //
+//-------------------------------------------//
+
+/*
+ * Parse `mutStr` with the format range [*fmtp, fmtEnd).
+ * On return, *fmtp points to the first format character that was not consumed.
+ */
+static int16_t
+strsepf_parse_(strsepf_state_* state, char const** fmtp, char const* fmtEnd)
+{
+    char const* fmt = *fmtp;
+
+    int count = 0;
+    while (state->mutStr != NULL && *state->mutStr && fmt < fmtEnd && !state->stopped) {
+        state->field = state->mutStr;
+        state->fieldFmt = fmt;
+
+        if (*fmt == '%') {
+            STRSEPF_PROFILE_STAGE(STRSEPF_STAGE_FORMAT);
+            fmt++;
+
+            if (fmt < fmtEnd && *fmt == '%') {
+                fmt++;
+                state->mutStr++; //< `%%` is just the `%` character.
+                continue;
+            }
+
+            if (fmt < fmtEnd && *fmt == '{') {
+                int16_t rc = strsepf_parse_group_(state, &fmt, fmtEnd);
+                if (rc < STRSEPF_RESULT_OK) {
+                    return rc;
+                }
+                count += rc;
+                continue;
+            }
+
+            strsepf_specifier_ spec;
+            strsepf_result     rc = strsepf_decode_specifier_(&fmt, fmtEnd, &spec);
+            if (rc < STRSEPF_RESULT_OK) {
+                return rc;
+            }
+
+            // Tokenisation
+            STRSEPF_PROFILE_STAGE(STRSEPF_STAGE_SCAN);
+            char*      token;
+            const bool continueUntilTheEnd = (fmt == fmtEnd && state->stop == '\0');
+            if (continueUntilTheEnd) {
+                token = state->mutStr;
+                state->mutStr += strlen(token);
+
+            } else {
+                // NOTE:
+                // If termination is not found in `mutStr`, will return the entier string.
+                // Inside a group, the group stop character also terminates the token.
+                char const termination[] = { fmt < fmtEnd ? *fmt : state->stop, state->stop, '\0' };
+                token = state->mutStr;
+                char* const end = strsepf_scan_(token, termination);
+                if (state->stop != '\0' && (fmt == fmtEnd || *fmt != state->stop)) {
+                    state->stopped = (*end != '\0' && *end == state->stop);
+                }
+                state->mutStr = (*end == '\0') ? NULL : end + 1;
+                state->cut = end;
+                state->cutChar = *end;
+                *end = '\0';
+                if (fmt < fmtEnd) {
+                    fmt++;
+                }
+            }
+
+            // Optinal specifier logic
+            STRSEPF_PROFILE_STAGE(STRSEPF_STAGE_WIDTH);
+            strsepf_predicate const* predicate = NULL;
+            if (spec.predicate) {
+                predicate = strsepf_next_predicate_(state);
+                if (predicate == NULL || !strsepf_predicate_fits_(predicate, spec.type)) {
+                    return STRSEPF_RESULT_ERR_INVALID_ARGS;
+                }
+            }
+            if (spec.noAssign && predicate == NULL) {
+                continue; //< ignore it.
+            }
+            if (spec.width > 0) {
+                if (spec.width < strlen(token)) {
+                    return STRSEPF_RESULT_ERR_TOKEN_IS_BIGGER_THAN_WIDTH;
+                }
+            }
+
+            // Scan string
+            STRSEPF_PROFILE_STAGE(STRSEPF_STAGE_CONVERT);
+            strsepf_result strtolErr = STRSEPF_RESULT_OK;
+            if (spec.type == 's') {
+                if (predicate != NULL && !strsepf_predicate_string(predicate, token)) {
+                    return STRSEPF_RESULT_ERR_PREDICATE_REJECTED;
+                }
+                if (spec.noAssign) {
+                    continue;
+                }
+                STRSEPF_PROFILE_STAGE(STRSEPF_STAGE_STORE);
+                char** ptr = strsepf_next_str_(state);
+                if (ptr == NULL) {
+                    return STRSEPF_RESULT_ERR_INVALID_ARGS;
+                }
+                strsepf_result const storeErr = strsepf_store_str_(state, token, ptr);
+                if (storeErr < STRSEPF_RESULT_OK) {
+                    return storeErr;
+                }
+                count++;
+            }
+            // Intern a string
+            else if (spec.type == 'k') {
+                if (predicate != NULL && !strsepf_predicate_string(predicate, token)) {
+                    return STRSEPF_RESULT_ERR_PREDICATE_REJECTED;
+                }
+                if (spec.noAssign) {
+                    continue;
+                }
+                strsepf_intern* intern = strsepf_next_intern_(state);
+                uint32_t*       ptr = strsepf_next_u32_(state);
+                if (intern == NULL || ptr == NULL) {
+                    return STRSEPF_RESULT_ERR_INVALID_ARGS;
+                }
+                int32_t const id = strsepf_intern_id(intern, token);
+                if (id < STRSEPF_RESULT_OK) {
+                    return (int16_t)id;
+                }
+                STRSEPF_PROFILE_STAGE(STRSEPF_STAGE_STORE);
+                *ptr = (uint32_t)id;
+                count++;
+            }
+            // Scan an unsigned int
+            else if (strchr("uxob", spec.type) != NULL) {
+                uint8_t   base = strsepf_base_(spec.type);
+                uint32_t* ptr = spec.noAssign ? NULL : strsepf_next_u32_(state);
+                if (ptr == NULL && !spec.noAssign) {
+                    return STRSEPF_RESULT_ERR_INVALID_ARGS;
+                }
+                uint32_t value = strtou32_s(token, base, &strtolErr);
+                if (strtolErr < STRSEPF_RESULT_OK) {
+                    return strtolErr;
+                }
+                if (predicate != NULL && !strsepf_predicate_number(predicate, value)) {
+                    return STRSEPF_RESULT_ERR_PREDICATE_REJECTED;
+                }
+                if (spec.noAssign) {
+                    continue;
+                }
+                STRSEPF_PROFILE_STAGE(STRSEPF_STAGE_STORE);
+                *ptr = value;
+                count++;
+            }
+            // Scan a signed int
+            else if (strchr("di", spec.type) != NULL) {
+                uint8_t  base = strsepf_base_(spec.type);
+                int32_t* ptr = spec.noAssign ? NULL : strsepf_next_i32_(state);
+                if (ptr == NULL && !spec.noAssign) {
+                    return STRSEPF_RESULT_ERR_INVALID_ARGS;
+                }
+                int32_t value = strto32_s(token, base, &strtolErr);
+                if (strtolErr < STRSEPF_RESULT_OK) {
+                    return strtolErr;
+                }
+                if (predicate != NULL && !strsepf_predicate_number(predicate, value)) {
+                    return STRSEPF_RESULT_ERR_PREDICATE_REJECTED;
+                }
+                if (spec.noAssign) {
+                    continue;
+                }
+                STRSEPF_PROFILE_STAGE(STRSEPF_STAGE_STORE);
+                *ptr = value;
+                count++;
+            } else {
+                return STRSEPF_RESULT_ERR_INVALID_FORMAT; //< Specifier not handled -> should not
+                                                          // happen
+            }
+
+        } else { /* !(*fmt == '%') */
+            STRSEPF_PROFILE_STAGE(STRSEPF_STAGE_LITERAL);
+            if (*fmt != *state->mutStr) {
+                return STRSEPF_RESULT_ERR_INPUT_DOESNT_MATCH_FORMAT;
+            } else {
+                fmt++;
+                state->mutStr++;
+            }
+        } // END if (*fmt == '%')
+    }     // END while (*mutStr && *fmt)
+
+    // A group right at the end of the input is an empty list: it still stores its
+    // number of repetitions.
+    bool const inputEnded = (state->mutStr == NULL || *state->mutStr == '\0');
+    if (inputEnded && !state->stopped && fmtEnd - fmt >= 2 && fmt[0] == '%' && fmt[1] == '{') {
+        fmt++;
+        int16_t rc = strsepf_parse_group_(state, &fmt, fmtEnd);
+        if (rc < STRSEPF_RESULT_OK) {
+            return rc;
+        }
+        count += rc;
+    }
+
+    *fmtp = fmt;
+    return count;
+}
+
+/*
+ * Parse a repeated group. *fmtp points to the `{` of the group.
+ * See the `vstrsepf` declaration for the group syntax.
+ */
+static int16_t
+strsepf_parse_group_(strsepf_state_* state, char const** fmtp, char const* fmtEnd)
+{
+    if (state->groupArgs != NULL) {
+        return STRSEPF_RESULT_ERR_INVALID_FORMAT; //< Groups can't be nested
+    }
+
+    // A group follows this prototype: [=%{body}capacity=]
+    char const* body = *fmtp + 1;
+    char const* bodyEnd = memchr(body, '}', (size_t)(fmtEnd - body));
+    if (bodyEnd == NULL) {
+        return STRSEPF_RESULT_ERR_INVALID_FORMAT;
+    }
+
+    char const* fmt = bodyEnd + 1;
+    if (fmt >= fmtEnd || !isdigit(*fmt)) {
+        return STRSEPF_RESULT_ERR_INVALID_FORMAT; //< The capacity is mandatory
+    }
+    uint64_t capacity = 0;
+    for (; fmt < fmtEnd && isdigit(*fmt); fmt++) {
+        capacity = capacity * 10 + (uint64_t)(*fmt - '0');
+        if (capacity > UINT32_MAX) {
+            return STRSEPF_RESULT_ERR_INVALID_FORMAT;
+        }
+    }
+    if (capacity == 0) {
+        return STRSEPF_RESULT_ERR_INVALID_FORMAT;
+    }
+
+    // Fetch the group arguments once, they are reused by every repetition.
+    size_t* repetitions = va_arg(*state->arg, size_t*);
+    if (repetitions == NULL) {
+        return STRSEPF_RESULT_ERR_INVALID_ARGS;
+    }
+
+    strsepf_arg_ args[STRSEPF_GROUP_MAX_ARGS];
+    size_t       nArgs = 0;
+    for (char const* f = body; f < bodyEnd; f++) {
+        if (*f != '%') {
+            continue;
+        }
+        f++;
+        if (f < bodyEnd && *f == '%') {
+            continue;
+        }
+        if (f < bodyEnd && *f == '{') {
+            return STRSEPF_RESULT_ERR_INVALID_FORMAT; //< Groups can't be nested
+        }
+
+        strsepf_specifier_ spec;
+        strsepf_result     rc = strsepf_decode_specifier_(&f, bodyEnd, &spec);
+        if (rc < STRSEPF_RESULT_OK) {
+            return rc;
+        }
+        f--; //< Points to the specifier type
+
+        size_t const nFieldArgs = (size_t)spec.predicate + (spec.type == 'k') + 1;
+        if (nArgs + nFieldArgs > STRSEPF_GROUP_MAX_ARGS) {
+            return STRSEPF_RESULT_ERR_INVALID_FORMAT; //< Too many fields in the group
+        }
+        if (spec.predicate) {
+            args[nArgs].predicate = va_arg(*state->arg, strsepf_predicate const*);
+            if (args[nArgs++].predicate == NULL) {
+                return STRSEPF_RESULT_ERR_INVALID_ARGS;
+            }
+        }
+        if (spec.noAssign) {
+            continue;
+        }
+        if (spec.type == 'k') {
+            args[nArgs].intern = va_arg(*state->arg, strsepf_intern*);
+            if (args[nArgs++].intern == NULL) {
+                return STRSEPF_RESULT_ERR_INVALID_ARGS;
+            }
+        }
+        bool isNull;
+        if (spec.type == 's') {
+            args[nArgs].strs = va_arg(*state->arg, char**);
+            isNull = (args[nArgs].strs == NULL);
+        } else if (strchr("uxobk", spec.type) != NULL) {
+            args[nArgs].u32s = va_arg(*state->arg, uint32_t*);
+            isNull = (args[nArgs].u32s == NULL);
+        } else {
+            args[nArgs].i32s = va_arg(*state->arg, int32_t*);
+            isNull = (args[nArgs].i32s == NULL);
+        }
+        if (isNull) {
+            return STRSEPF_RESULT_ERR_INVALID_ARGS;
+        }
+        nArgs++;
+    }
+
+    // Parse the body up to `capacity` times
+    strsepf_state_ group = *state;
+    group.groupArgs = args;
+    group.stop = (fmt < fmtEnd && *fmt != '%') ? *fmt : '\0'; //< Only a literal can stop a group
+    group.stopped = false;
+
+    size_t n = 0;
+    while (n < capacity && group.mutStr != NULL && *group.mutStr != '\0') {
+        group.groupArg = 0;
+        group.index = n;
+
+        char const* bodyFmt = body;
+        int16_t     rc = strsepf_parse_(&group, &bodyFmt, bodyEnd);
+        if (rc >= STRSEPF_RESULT_OK && bodyFmt != bodyEnd) {
+            rc = STRSEPF_RESULT_ERR_INPUT_DOESNT_MATCH_FORMAT; //< Incomplete repetition
+        }
+        if (rc < STRSEPF_RESULT_OK) {
+            state->field = group.field;
+            state->fieldFmt = group.fieldFmt;
+            state->cut = group.cut;
+            state->cutChar = group.cutChar;
+            return rc;
+        }
+        n++;
+
+        if (group.stopped) {
+            fmt++; //< The stop character was consumed with the last token
+            break;
+        }
+    }
+
+    state->mutStr = group.mutStr;
+    *repetitions = n;
+    *fmtp = fmt;
+    return 1;
+}
+
+/*
+ * Decode a format specifier. *fmtp points right after the `%`.
+ * On success, *fmtp points right after the specifier type.
+ */
+static strsepf_result
+strsepf_decode_specifier_(char const** fmtp, char const* fmtEnd, strsepf_specifier_* spec)
+{
+#define SUPPORTED_SPECIFIER "dibouxsk"
+
+    // A format specifier follows this prototype: [=%[*][?][width][modifiers]type=]
+    char const* fmt = *fmtp;
+    spec->type = '\0';
+    spec->noAssign = false;
+    spec->predicate = false;
+    spec->width = 0;
+    for (; (fmt < fmtEnd && *fmt != '\0'); fmt++) {
+        if (strchr(SUPPORTED_SPECIFIER, *fmt) != NULL) {
+            spec->type = *fmt;
+            fmt++;
+            break; //< Specifier type is always the last element of a specifier string
+
+        } else if (*fmt == '*') {
+            spec->noAssign = true;
+
+        } else if (*fmt == '?') {
+            spec->predicate = true;
+
+        } else if (*fmt >= '1' && *fmt <= '9') {
+            char const* tc;
+            for (tc = fmt; isdigit(*fmt); fmt++)
+                ;
+
+            strsepf_result err;
+            spec->width = strtou32_s(tc, 10, &err);
+            if (err != STRSEPF_RESULT_ERR_STRTOI_EXTRA_CHAR) {
+                return STRSEPF_RESULT_ERR_INVALID_FORMAT; //< width shall be follow by a
+                                                          // specifier type
+            }
+            fmt--;
+        } else {
+            return STRSEPF_RESULT_ERR_INVALID_FORMAT;
+        }
+    }
+
+    if (spec->type == '\0') {
+        return STRSEPF_RESULT_ERR_INVALID_FORMAT;
+    }
+    *fmtp = fmt;
+    return STRSEPF_RESULT_OK;
+}
+
+/*
+ * Base of an integer specifier type.
+ */
+static uint8_t
+strsepf_base_(char type)
+{
+    switch (type) {
+        case 'x':
+            return 16;
+        case 'o':
+            return 8;
+        case 'b':
+            return 2;
+        default:
+            return 10;
+    }
+}
+
+/*
+ * Check that a predicate applies to a specifier type: ranges are only defined
+ * on numbers.
+ */
+static bool
+strsepf_predicate_fits_(strsepf_predicate const* predicate, char type)
+{
+    return !(predicate->type == STRSEPF_PREDICATE_RANGE && (type == 's' || type == 'k'));
+}
+
+/*
+ * FNV-1a hash of a string, used by the key/value perfect hash and the intern table.
+ * `strsepf_hash_init_` and `strsepf_hash_step_` hash a string while it is scanned:
+ * they must give the same value as `strsepf_hash_` for the same characters.
+ */
+static uint32_t
+strsepf_hash_init_(uint32_t seed)
+{
+    return 2166136261u ^ seed;
+}
+
+static uint32_t
+strsepf_hash_step_(uint32_t hash, char c)
+{
+    return (hash ^ (uint8_t)c) * 16777619u;
+}
+
+static uint32_t
+strsepf_hash_(char const* key, size_t len, uint32_t seed)
+{
+    uint32_t hash = strsepf_hash_init_(seed);
+    for (size_t i = 0; i < len; i++) {
+        hash = strsepf_hash_step_(hash, key[i]);
+    }
+    return hash;
+}
+
+/*
+ * Copy a string into an arena. Returns NULL if the arena is full.
+ */
+static char*
+strsepf_arena_copy_(strsepf_arena* arena, char const* str)
+{
+    size_t const size = strlen(str) + 1;
+    if (size > arena->cap - arena->used) {
+        return NULL;
+    }
+    char* const copy = memcpy(&arena->base[arena->used], str, size);
+    arena->used += size;
+    return copy;
+}
+
+/*
+ * Store a `%s` token, or its copy when parsing into an arena.
+ */
+static strsepf_result
+strsepf_store_str_(strsepf_state_* state, char* token, char** ptr)
+{
+    strsepf_arena* const arena = state->arena;
+    if (arena == NULL) {
+        *ptr = token;
+        return STRSEPF_RESULT_OK;
+    }
+
+    char* const copy = strsepf_arena_copy_(arena, token);
+    if (copy == NULL) {
+        return STRSEPF_RESULT_ERR_ARENA_FULL;
+    }
+    *ptr = copy;
+    return STRSEPF_RESULT_OK;
+}
+
+/*
+ * Arguments getters.
+ * Outside a group, arguments come from the va_list. Inside a group, they are the
+ * current element of the arrays fetched at the start of the group.
+ */
+static strsepf_predicate const*
+strsepf_next_predicate_(strsepf_state_* state)
+{
+    if (state->groupArgs == NULL) {
+        return va_arg(*state->arg, strsepf_predicate const*);
+    }
+    return state->groupArgs[state->groupArg++].predicate;
+}
+
+static strsepf_intern*
+strsepf_next_intern_(strsepf_state_* state)
+{
+    if (state->groupArgs == NULL) {
+        return va_arg(*state->arg, strsepf_intern*);
+    }
+    return state->groupArgs[state->groupArg++].intern;
+}
+
+static char**
+strsepf_next_str_(strsepf_state_* state)
+{
+    if (state->groupArgs == NULL) {
+        return va_arg(*state->arg, char**);
+    }
+    return &state->groupArgs[state->groupArg++].strs[state->index];
+}
+
+static uint32_t*
+strsepf_next_u32_(strsepf_state_* state)
+{
+    if (state->groupArgs == NULL) {
+        return va_arg(*state->arg, uint32_t*);
+    }
+    return &state->groupArgs[state->groupArg++].u32s[state->index];
+}
+
+static int32_t*
+strsepf_next_i32_(strsepf_state_* state)
+{
+    if (state->groupArgs == NULL) {
+        return va_arg(*state->arg, int32_t*);
+    }
+    return &state->groupArgs[state->groupArg++].i32s[state->index];
+}
+
+//-------------------------------------------//
+//                                           //
+//    Helper functions Implemetation         //
+//                                           //
+//-------------------------------------------//
+
+uint32_t
+strtou32_s(const char buff[], uint8_t base, strsepf_result* err)
+{
+    if (err == NULL) {
+        return 0;
+    }
+    if (buff == NULL || base == 0) {
+        *err = STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+        return 0;
+    }
+
+    char* end;
+    errno = 0;
+
+    const unsigned long ul = strtoul(buff, &end, base);
+    if (end == buff) {
+        *err = STRSEPF_RESULT_ERR_STRTOI_NOT_A_DECIMAL; //< not a decimal number
+
+    } else if ('\0' != *end) {
+        *err = STRSEPF_RESULT_ERR_STRTOI_EXTRA_CHAR; //< extra characters at end of input
+
+    } else if (ERANGE == errno) {
+        *err = STRSEPF_RESULT_ERR_STRTOI_OUT_OF_RANGE; //< out of range of type u long
+
+    } else if (ul > UINT32_MAX) {
+        *err = STRSEPF_RESULT_ERR_STRTOI_OUT_OF_RANGE; //< greater than MAX
+
+    } else {
+        *err = STRSEPF_RESULT_OK; //< ok
+    }
+    return (uint32_t)ul;
+}
+
+int32_t
+strto32_s(const char buff[], uint8_t base, strsepf_result* err)
+{
+    if (err == NULL) {
+        return 0;
+    }
+    if (buff == NULL || base == 0) {
+        *err = STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+        return 0;
+    }
+
+    char* end;
+    errno = 0;
+
+    const long sl = strtoul(buff, &end, base);
+    if (end == buff) {
+        *err = STRSEPF_RESULT_ERR_STRTOI_NOT_A_DECIMAL; //< not a decimal number
+
+    } else if ('\0' != *end) {
+        *err = STRSEPF_RESULT_ERR_STRTOI_EXTRA_CHAR; //< extra characters at end of input
+
+    } else if (ERANGE == errno) {
+        *err = STRSEPF_RESULT_ERR_STRTOI_OUT_OF_RANGE; //< out of range of type u long
+
+    } else if (sl > INT32_MAX) {
+        *err = STRSEPF_RESULT_ERR_STRTOI_OUT_OF_RANGE; //< greater than MAX
+
+    } else if (sl < INT32_MIN) {
+        *err = STRSEPF_RESULT_ERR_STRTOI_OUT_OF_RANGE; //< less than MIN
+
+    } else {
+        *err = STRSEPF_RESULT_OK; //< ok
+    }
+    return (int32_t)sl;
+}
+
+bool
+strsepf_predicate_number(strsepf_predicate const* predicate, int64_t value)
+{
+    if (predicate == NULL) {
+        return false;
+    }
+
+    switch (predicate->type) {
+        case STRSEPF_PREDICATE_EQUAL:
+            return value == predicate->min;
+
+        case STRSEPF_PREDICATE_RANGE:
+            return value >= predicate->min && value <= predicate->max;
+
+        case STRSEPF_PREDICATE_ONE_OF:
+            if (predicate->nums == NULL) {
+                return false;
+            }
+            for (size_t i = 0; i < predicate->len; i++) {
+                if (predicate->nums[i] == value) {
+                    return true;
+                }
+            }
+            return false;
+
+        default:
+            return false;
+    }
+}
+
+bool
+strsepf_predicate_string(strsepf_predicate const* predicate, char const* token)
+{
+    if (predicate == NULL || token == NULL) {
+        return false;
+    }
+
+    switch (predicate->type) {
+        case STRSEPF_PREDICATE_EQUAL:
+            return predicate->str != NULL && strcmp(predicate->str, token) == 0;
+
+        case STRSEPF_PREDICATE_ONE_OF:
+            if (predicate->strs == NULL) {
+                return false;
+            }
+            for (size_t i = 0; i < predicate->len; i++) {
+                if (predicate->strs[i] != NULL && strcmp(predicate->strs[i], token) == 0) {
+                    return true;
+                }
+            }
+            return false;
+
+        case STRSEPF_PREDICATE_RANGE: //< Not supported on strings
+        default:
+            return false;
+    }
+}
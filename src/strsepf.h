@@ -17,19 +17,14 @@
 //                Includes                   //
 //                                           //
 //-------------------------------------------//
-#include <ctype.h>   //< cstdlib : isdigit
-#include <errno.h>   //< cstdlib : For strtol_s
-#include <stdarg.h>  //< cstdlib : va_list, va_start, va_arg, va_end
+#include <stdarg.h>  //< cstdlib : va_list
 #include <stdbool.h> //< cstdlib : bool
+#include <stddef.h>  //< cstdlib : size_t
 #include <stdint.h>  //< cstdlib : *int*_t, limit
-#include <stdlib.h>  //< cstdlib : strtol
-#include <string.h>  //< cstdlib : strchr
 
-// NOTE:
-// `strsep` is not a POSIX or Linux standard function, it's a BSD function. Therefore, there's no
-// garantiy it will be included in `string.h`.
-// We can include it manually:
-#include "strsep.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 //-------------------------------------------//
 //                                           //
@@ -37,12 +32,29 @@
 //                                           //
 //-------------------------------------------//
 
+// Visibility of the library functions. The library is built with hidden symbols.
+#ifndef STRSEPF_API
+#if defined(__GNUC__) || defined(__clang__)
+#define STRSEPF_API __attribute__((visibility("default")))
+#else
+#define STRSEPF_API
+#endif
+#endif
+
 /*
  * Enumerates all the possible errors for the strsepf function.
  * All non-negative number are not an error.
  */
 typedef enum
 {
+    // Arena error
+    STRSEPF_RESULT_ERR_INTERN_FULL = -13,
+    STRSEPF_RESULT_ERR_ARENA_FULL = -12,
+    // Pipeline error
+    STRSEPF_RESULT_ERR_IO = -11,
+    STRSEPF_RESULT_ERR_RECORD_TOO_LONG = -10,
+    // Predicate error
+    STRSEPF_RESULT_ERR_PREDICATE_REJECTED = -9,
     // Number conversion error
     STRSEPF_RESULT_ERR_STRTOI_OUT_OF_RANGE = -8,
     STRSEPF_RESULT_ERR_STRTOI_EXTRA_CHAR = -7,
@@ -58,32 +70,124 @@ typedef enum
     STRSEPF_RESULT_OK = 0,
 } strsepf_result;
 
-//-------------------------------------------//
-//                                           //
-//               Interface                   //
-//                                           //
-//-------------------------------------------//
+/*
+ * Enumerates the kinds of predicate that can be attached to a field with the
+ * `?` optional specifier.
+ */
+typedef enum
+{
+    STRSEPF_PREDICATE_EQUAL,  //< Numbers: value == min.        Strings: token == str.
+    STRSEPF_PREDICATE_RANGE,  //< Numbers: min <= value <= max. Strings: invalid argument.
+    STRSEPF_PREDICATE_ONE_OF, //< Numbers: value in nums[len].  Strings: token in strs[len].
+} strsepf_predicate_type;
 
-int16_t
-strsepf(char mutStr[], char const* fmt, ...);
+/*
+ * A predicate on a field value.
+ * When it fails, the parsing stops right away: the remaining fields are neither
+ * tokenized nor converted.
+ *
+ *  eg - Only keep the $GPGGA sentences
+ *
+ *    strsepf_predicate const isGGA = { .type = STRSEPF_PREDICATE_EQUAL, .str = "GPGGA" };
+ *    int16_t n = strsepf(msg, "$%*?s,%d,%s", &isGGA, &utcTime, &lat);
+ */
+typedef struct
+{
+    strsepf_predicate_type type;
+    int64_t                min;
+    int64_t                max;
+    char const*            str;
+    int64_t const*         nums;
+    char const* const*     strs;
+    size_t                 len;
+} strsepf_predicate;
+
+// Maximum number of keys of a key/value format.
+#ifndef STRSEPF_KV_MAX_KEYS
+#define STRSEPF_KV_MAX_KEYS 32
+#endif
+
+// Maximum size of the key/value perfect hash table.
+#define STRSEPF_KV_TABLE_SIZE (2 * STRSEPF_KV_MAX_KEYS)
 
-int16_t
-vstrsepf(char mutStr[], char const* fmt, va_list arg);
+/*
+ * A compiled key/value format. See `strsepf_kv_compile`.
+ * Keys point into the format string: it must outlive this structure.
+ */
+typedef struct
+{
+    char     pairSep;                       //< Character between two pairs (eg ' ')
+    char     kvSep;                         //< Character between a key and its value (eg '=')
+    uint8_t  nKeys;                         //< Number of keys
+    uint8_t  tableMask;                     //< Size of the hash table - 1
+    uint32_t seed;                          //< Seed making the hash perfect for these keys
+    uint8_t  table[STRSEPF_KV_TABLE_SIZE];  //< Key index + 1 for every slot, 0 if empty
+    struct
+    {
+        char const* name;
+        uint8_t     len;
+        char        type;
+        bool        noAssign;
+        bool        predicate;
+        uint32_t    width;
+    } keys[STRSEPF_KV_MAX_KEYS];
+} strsepf_kv;
+
+// Default characters starting a new record, for the resynchronization of `strsepf_diag`.
+#define STRSEPF_RESYNC_DEFAULT "$\n"
 
-//-------------------------------------------//
-//                                           //
-//           Helper functions                //
-//                                           //
-//-------------------------------------------//
-uint32_t
-strtou32_s(const char* buff, uint8_t base, strsepf_result* err);
+/*
+ * Diagnostics of a failed parsing. See `vstrsepf_diag`.
+ */
+typedef struct
+{
+    int16_t result;       //< Same as the return value
+    size_t  inputOffset;  //< Offset in the input of the token or literal that failed
+    size_t  formatOffset; //< Offset in the format of the specifier or literal that failed
+    char*   resync;       //< Start of the next record after the failure, NULL if none
+} strsepf_error_info;
 
-int32_t
-strto32_s(const char* buff, uint8_t base, strsepf_result* err);
+/*
+ * A bump arena in caller memory, receiving the `%s` tokens of `strsepf_copy`.
+ * Allocating is a pointer bump, freeing is `strsepf_arena_reset` (eg once per batch).
+ */
+typedef struct
+{
+    char*  base; //< Caller memory
+    size_t cap;  //< Size of `base`
+    size_t used; //< Bytes handed out since the last reset
+} strsepf_arena;
+
+/*
+ * A fixed capacity string interning table in caller memory, filled by the `%k`
+ * specifier. See `strsepf_intern_init`.
+ * Every distinct string is stored once and gets a small dense id (0, 1, 2...).
+ */
+typedef struct
+{
+    uint32_t*     slots;  //< Open addressing table: id + 1 for every slot, 0 if empty
+    char const**  strs;   //< String of every id
+    uint32_t      mask;   //< Number of slots - 1
+    uint32_t      maxIds; //< Maximum number of strings (3/4 of the slots)
+    uint32_t      nIds;   //< Number of strings
+    strsepf_arena arena;  //< Storage of the strings
+} strsepf_intern;
+
+/*
+ * Enumerates the instruction sets of the tokenizing and number conversion kernels.
+ * The best one supported by the CPU is selected when the library is loaded.
+ */
+typedef enum
+{
+    STRSEPF_SIMD_SCALAR = 0,
+    STRSEPF_SIMD_SSE42 = 1,
+    STRSEPF_SIMD_AVX2 = 2,
+    STRSEPF_SIMD_AVX512 = 3, //< AVX-512F and AVX-512BW
+} strsepf_simd;
 
 //-------------------------------------------//
 //                                           //
-//              Implementation               //
+//               Interface                   //
 //                                           //
 //-------------------------------------------//
 
@@ -91,16 +195,8 @@ strto32_s(const char* buff, uint8_t base, strsepf_result* err);
  * `strsepf` is a wrapper to `vstrsepf`.
  * See the `vstrsepf` declaration for more information.
  */
-int16_t
-strsepf(char mutStr[], char const* fmt, ...)
-{
-    int16_t rc;
-    va_list arg;
-    va_start(arg, fmt);
-    rc = vstrsepf(mutStr, fmt, arg);
-    va_end(arg);
-    return rc;
-}
+STRSEPF_API int16_t
+strsepf(char mutStr[], char const* fmt, ...);
 
 /*
  * `vstrsepf` is string parsing utility function born from
@@ -174,8 +270,11 @@ strsepf(char mutStr[], char const* fmt, ...)
  *  | %o          | Any number of octal digits (0-7)                                |
  *  | %x          | Any number of hexadecimal digits (0-9, a-f, A-F*)               |
  *  | %%          | A % followed by another % matches a single %.                   |
+ *  | %k          | A string interned in a `strsepf_intern` table, stored as its    |
+ *  |             | `uint32_t` id. Takes the table, then the id pointer.            |
  *  | %s          | A string with any character in it. A terminating null character |
  *  |             | is automatically added at the end of the stored sequence.#      |
+ *  | %{body}N    | A group of specifiers repeated up to N times. See below.        |
  *
  * FORMAT OPTIONAL SPECIFIER:
  *
@@ -185,230 +284,303 @@ strsepf(char mutStr[], char const* fmt, ...)
  *  |             | read from the stream but ignored.                               |
  *  | width       | Specifies the maximum number of characters to be read in the    |
  *  |             | current reading operation.                                      |
+ *  | ?           | The field must satisfy a `strsepf_predicate`, passed as an      |
+ *  |             | argument right before the field's own argument. The parsing     |
+ *  |             | stops with STRSEPF_RESULT_ERR_PREDICATE_REJECTED as soon as a   |
+ *  |             | predicate fails. Can be combined with `*` (filter only).        |
+ *  |             | A range predicate on a %s or %k field is an invalid argument.   |
+ *
+ * REPEATED GROUPS:
+ *
+ *  `%{body}N` parses `body` up to N times in a single pass and stores each field
+ *  of the body in a caller array of capacity N. The group arguments are:
+ *  - a `size_t*` receiving the number of complete repetitions,
+ *  - then, for every field of the body, its predicate (if `?`) and its array
+ *    (`char**` for %s, `uint32_t*` for %u %x %o %b, `int32_t*` for %d %i, a
+ *    `strsepf_intern*` then a `uint32_t*` for %k).
+ *
+ *  The group stops after N repetitions, at the end of the input, or when a field
+ *  is terminated by the literal character following `}N` in the format. A group counts
+ *  as one parsed argument, even when the input ends right before it (0 repetitions).
+ *  At the end of the input, the last repetition can miss the delimiter of its last
+ *  field: "1,2,3" and "1,2,3," both give 3 repetitions of `%{%d,}8`. A repetition
+ *  missing a field is an error (STRSEPF_RESULT_ERR_INPUT_DOESNT_MATCH_FORMAT).
+ *  N is at most UINT32_MAX. Groups can't be nested.
+ *
+ *  eg - Parse the satellites of a $GPGSV message
  *
+ *    char msg[] = "$GPGSV,3,3,10,29,09,301,24,30,12,040,44*74";
  *
+ *    size_t  nSats = 0;
+ *    int32_t prn[4], elevation[4], azimuth[4], snr[4];
+ *    int16_t n = strsepf(msg, "$GPGSV,%*d,%*d,%*d,%{%d,%d,%d,%d,}4*%*x",
+ *                        &nSats, prn, elevation, azimuth, snr);
+ *
+ *    TEST_ASSERT_EQUAL(1, n);     //< Will pass.
+ *    TEST_ASSERT_EQUAL(2, nSats); //< Will pass.
  *
  */
-int16_t
-vstrsepf(char mutStr[], char const* fmt, va_list arg)
-{
-    if (mutStr == NULL || fmt == NULL) {
-        return STRSEPF_RESULT_ERR_INVALID_PARAMETER;
-    }
-
-#define SUPPORTED_SPECIFIER "dibouxs"
-
-    int count = 0;
-    while (*mutStr && *fmt) {
-
-        if (*fmt == '%') {
-            fmt++;
-
-            if (*fmt == '%') {
-                fmt++;
-                mutStr++; //< `%%` is just the `%` character.
-                continue;
-            }
-
-            // A format specifier follows this prototype: [=%[*][width][modifiers]type=]
-            char     specifierType = '\0';
-            bool     noAssignFlag = false;
-            uint32_t width = 0;
-            for (; (*fmt != '\0' && fmt != NULL); fmt++) {
-                if (strchr(SUPPORTED_SPECIFIER, *fmt) != NULL) {
-                    specifierType = *fmt;
-                    fmt++;
-                    break; //< Specifier type is always the last element of a specifier string
-
-                } else if (*fmt == '*') {
-                    noAssignFlag = true;
-
-                } else if (*fmt >= '1' && *fmt <= '9') {
-                    char const* tc;
-                    for (tc = fmt; isdigit(*fmt); fmt++)
-                        ;
-
-                    strsepf_result err;
-                    width = strtou32_s(tc, 10, &err);
-                    if (err != STRSEPF_RESULT_ERR_STRTOI_EXTRA_CHAR) {
-                        return STRSEPF_RESULT_ERR_INVALID_FORMAT; //< width shall be follow by a
-                                                                  // specifier type
-                    }
-                    fmt--;
-                } else {
-                    return STRSEPF_RESULT_ERR_INVALID_FORMAT;
-                }
-            }
-
-            if (specifierType == '\0') {
-                return STRSEPF_RESULT_ERR_INVALID_FORMAT;
-            }
-
-            // Tokenisation
-            char*      token;
-            const bool continueUntilTheEnd = (*fmt == '\0');
-            if (continueUntilTheEnd) {
-                token = mutStr;
-
-            } else {
-                // NOTE:
-                // If termination is not found in `mutStr`, will return the entier string
-                char termination[] = { *fmt, '\0' };
-                token = strsep(&mutStr, termination);
-                if (token == NULL) {
-                    return STRSEPF_RESULT_ERR_INPUT_DOESNT_MATCH_FORMAT; //< no token found
-                }
-                fmt++;
-            }
-
-            // Optinal specifier logic
-            if (noAssignFlag) {
-                continue; //< ignore it.
-            }
-            if (width > 0) {
-                if (width < strlen(token)) {
-                    return STRSEPF_RESULT_ERR_TOKEN_IS_BIGGER_THAN_WIDTH;
-                }
-            }
-
-            // Scan string
-            strsepf_result strtolErr = STRSEPF_RESULT_OK;
-            if (specifierType == 's') {
-                char** ptr = va_arg(arg, char**);
-                if (ptr == NULL) {
-                    return STRSEPF_RESULT_ERR_INVALID_ARGS;
-                }
-                *ptr = token;
-                count++;
-            }
-            // Scan an unsigned int
-            else if (strchr("uxob", specifierType) != NULL) {
-                uint8_t base = 0;
-                if (specifierType == 'u') {
-                    base = 10;
-                } else if (specifierType == 'x') {
-                    base = 16;
-                } else if (specifierType == 'o') {
-                    base = 8;
-                } else if (specifierType == 'b') {
-                    base = 2;
-                }
-                uint32_t* ptr = va_arg(arg, uint32_t*);
-                if (ptr == NULL) {
-                    return STRSEPF_RESULT_ERR_INVALID_ARGS;
-                }
-                *ptr = strtou32_s(token, base, &strtolErr);
-                if (strtolErr < STRSEPF_RESULT_OK) {
-                    return strtolErr;
-                }
-                count++;
-            }
-            // Scan a signed int
-            else if (strchr("di", specifierType) != NULL) {
-                uint8_t  base = 10;
-                int32_t* ptr = va_arg(arg, int32_t*);
-                if (ptr == NULL) {
-                    return STRSEPF_RESULT_ERR_INVALID_ARGS;
-                }
-                *ptr = strto32_s(token, base, &strtolErr);
-                if (strtolErr < STRSEPF_RESULT_OK) {
-                    return strtolErr;
-                }
-                count++;
-            } else {
-                return STRSEPF_RESULT_ERR_INVALID_FORMAT; //< Specifier not handled -> should not
-                                                          // happen
-            }
-
-        } else { /* !(*fmt == '%') */
-            if (*fmt != *mutStr) {
-                return STRSEPF_RESULT_ERR_INPUT_DOESNT_MATCH_FORMAT;
-            } else {
-                fmt++;
-                mutStr++;
-            }
-        } // END if (*fmt == '%')
-    }     // END while (*mutStr && *fmt)
-    return count;
-}
+STRSEPF_API int16_t
+vstrsepf(char mutStr[], char const* fmt, va_list arg);
+
+/*
+ * `strsepf_copy` is a wrapper to `vstrsepf_copy`.
+ * See the `vstrsepf_copy` declaration for more information.
+ */
+STRSEPF_API int16_t
+strsepf_copy(strsepf_arena* arena, char mutStr[], char const* fmt, ...);
+
+/*
+ * `vstrsepf_copy` is `vstrsepf`, except that the `%s` tokens (including the ones of
+ * repeated groups) are copied into `arena`. The stored strings outlive `mutStr`:
+ * the input buffer can be reused right away.
+ *
+ * The copies are '\0' terminated and packed back to back. When the arena is too
+ * small, the parsing stops with STRSEPF_RESULT_ERR_ARENA_FULL. On any error, the
+ * arena is left as it was before the call.
+ *
+ * ARGUMENTS:
+ *  @param: arena  - Arena receiving the `%s` tokens.
+ *  @param: mutStr - Mutable input string (will be destroyed).
+ *  @param: fmt    - Format string.
+ *  @param: arg    - Aguments lists (va_list).
+ *
+ * RETURNS:
+ *  Same as `vstrsepf`.
+ *
+ * USAGE EXAMPLE:
+ *
+ *    char          memory[4096];
+ *    strsepf_arena arena;
+ *    strsepf_arena_init(&arena, memory, sizeof(memory));
+ *
+ *    char*   name = NULL;
+ *    int16_t n = strsepf_copy(&arena, line, "%*d,%s", &name);
+ *    // `line` can be overwritten, `name` is valid until `strsepf_arena_reset(&arena)`.
+ */
+STRSEPF_API int16_t
+vstrsepf_copy(strsepf_arena* arena, char mutStr[], char const* fmt, va_list arg);
+
+/*
+ * `strsepf_diag` is a wrapper to `vstrsepf_diag`.
+ * See the `vstrsepf_diag` declaration for more information.
+ */
+STRSEPF_API int16_t
+strsepf_diag(strsepf_error_info* info, char const* resync, char mutStr[], char const* fmt, ...);
+
+/*
+ * `vstrsepf_diag` is `vstrsepf`, with diagnostics when the parsing fails.
+ *
+ * `info` receives the offset in the input of the token (or literal) that failed,
+ * the offset in the format of its specifier (or literal), and a resynchronization
+ * pointer: the start of the next record after the failure, found with the
+ * vectorized delimiter scan. A record starts at one of the `resync` characters
+ * (eg '$'), or right after it for a line ending ('\n', '\r'). The delimiter of the
+ * failed token is put back in the input, so the rest of the input is intact.
+ *
+ * A corrupted stream can then be recovered in a single pass:
+ *
+ *    strsepf_error_info info;
+ *    while (record != NULL) {
+ *        int16_t n = strsepf_diag(&info, NULL, record, "$GPGGA,%d,%s\n", &time, &lat);
+ *        if (n < 0) {
+ *            log(info.inputOffset, info.formatOffset);
+ *        }
+ *        record = (n < 0) ? info.resync : next_record(...);
+ *    }
+ *
+ * ARGUMENTS:
+ *  @param: info   - Diagnostics (output).
+ *  @param: resync - Characters starting a record. NULL for STRSEPF_RESYNC_DEFAULT ("$\n").
+ *  @param: mutStr - Mutable input string (will be destroyed).
+ *  @param: fmt    - Format string.
+ *  @param: arg    - Aguments lists (va_list).
+ *
+ * RETURNS:
+ *  Same as `vstrsepf`.
+ */
+STRSEPF_API int16_t
+vstrsepf_diag(strsepf_error_info* info,
+              char const*         resync,
+              char                mutStr[],
+              char const*         fmt,
+              va_list             arg);
+
+/*
+ * Initialize an arena over `cap` bytes of caller memory.
+ */
+STRSEPF_API void
+strsepf_arena_init(strsepf_arena* arena, char memory[], size_t cap);
+
+/*
+ * Release all the strings of an arena at once.
+ */
+STRSEPF_API void
+strsepf_arena_reset(strsepf_arena* arena);
+
+/*
+ * Initialize a string interning table over caller memory.
+ *
+ * ARGUMENTS:
+ *  @param: intern - Table (output).
+ *  @param: slots  - Hash table, `nSlots` elements. `nSlots` shall be a power of 2.
+ *  @param: strs   - Strings by id, `nSlots` elements.
+ *  @param: nSlots - Number of slots. Up to 3/4 of them can be used.
+ *  @param: memory - Storage of the strings (with their '\0').
+ *  @param: cap    - Size of `memory`.
+ *
+ * RETURNS:
+ *  STRSEPF_RESULT_OK or STRSEPF_RESULT_ERR_INVALID_PARAMETER.
+ *
+ * USAGE EXAMPLE:
+ *
+ *    uint32_t       slots[64];
+ *    char const*    strs[64];
+ *    char           memory[512];
+ *    strsepf_intern units;
+ *    strsepf_intern_init(&units, slots, strs, 64, memory, sizeof(memory));
+ *
+ *    char     msg[] = "$GPBWC,081837,,,,,,T,,M,,N,*13";
+ *    uint32_t unit = 0;
+ *    strsepf(msg, "$%*sBWC,%*d,%*s,%*s,%*s,%*s,%*s,%k,", &units, &unit);
+ *
+ *    TEST_ASSERT_EQUAL_STRING("T", strsepf_intern_str(&units, unit)); //< Will pass.
+ */
+STRSEPF_API int16_t
+strsepf_intern_init(strsepf_intern* intern,
+                    uint32_t        slots[],
+                    char const*     strs[],
+                    size_t          nSlots,
+                    char            memory[],
+                    size_t          cap);
+
+/*
+ * Look a string up in an interning table, and add it if it isn't there yet.
+ *
+ * RETURNS:
+ *  Will return the id of the string, or STRSEPF_RESULT_ERR_INTERN_FULL
+ *  (STRSEPF_RESULT_ERR_ARENA_FULL) when there is no slot (memory) left for a new
+ *  string.
+ */
+STRSEPF_API int32_t
+strsepf_intern_id(strsepf_intern* intern, char const* str);
+
+/*
+ * String of an interned id, or NULL if the id is unknown.
+ */
+STRSEPF_API char const*
+strsepf_intern_str(strsepf_intern const* intern, uint32_t id);
+
+/*
+ * `strsepf_kv_compile` prepares a key/value format for `strsepf_kv_parse`.
+ *
+ * The format lists the expected keys, each followed by a format specifier:
+ * "key<kvSep>%spec<pairSep>key<kvSep>%spec...". The separators are deduced from
+ * the format and must be the same for all the pairs. The `*`, `?` and width
+ * optional specifiers are supported.
+ *
+ * A perfect hash of the keys is built once, so `strsepf_kv_parse` dispatches
+ * every key with a single hash and a single comparison.
+ *
+ * ARGUMENTS:
+ *  @param: kv  - Compiled format (output).
+ *  @param: fmt - Key/value format string. Must outlive `kv`.
+ *
+ * RETURNS:
+ *  Will return the number of keys or a negative number if the format is invalid.
+ *
+ * USAGE EXAMPLE:
+ *
+ *    strsepf_kv kv;
+ *    strsepf_kv_compile(&kv, "id=%d name=%s level=%u");
+ *
+ *    char     line[] = "level=3 host=a12 name=pump id=-7";
+ *    int32_t  id = 0;
+ *    char*    name = NULL;
+ *    uint32_t level = 0;
+ *    int16_t  n = strsepf_kv_parse(&kv, line, &id, &name, &level);
+ *
+ *    TEST_ASSERT_EQUAL(3, n);                   //< Will pass.
+ *    TEST_ASSERT_EQUAL(-7, id);                 //< Will pass.
+ *    TEST_ASSERT_EQUAL_STRING("pump", name);    //< Will pass.
+ *    TEST_ASSERT_EQUAL(3, level);               //< Will pass.
+ */
+STRSEPF_API int16_t
+strsepf_kv_compile(strsepf_kv* kv, char const* fmt);
+
+/*
+ * `strsepf_kv_parse` is a wrapper to `vstrsepf_kv_parse`.
+ * See the `vstrsepf_kv_parse` declaration for more information.
+ */
+STRSEPF_API int16_t
+strsepf_kv_parse(strsepf_kv const* kv, char mutStr[], ...);
+
+/*
+ * `vstrsepf_kv_parse` parses a "k1=v1 k2=v2 ..." string, with the keys in any order,
+ * in a single tokenizing pass.
+ *
+ * The arguments are given in the order of the keys in the compiled format, with
+ * the same types as `vstrsepf`. Every value is converted with its key specifier
+ * and stored in its argument. Unknown keys and tokens without a value are skipped.
+ * When a key appears more than once, the last value wins.
+ *
+ * ARGUMENTS:
+ *  @param: kv     - Format compiled by `strsepf_kv_compile`.
+ *  @param: mutStr - Mutable input string (will be destroyed).
+ *  @param: arg    - Aguments lists (va_list).
+ *
+ * RETURNS:
+ *  Will return the number of distinct keys parsed or a negative number if the
+ *  parsing failed.
+ */
+STRSEPF_API int16_t
+vstrsepf_kv_parse(strsepf_kv const* kv, char mutStr[], va_list arg);
 
 //-------------------------------------------//
 //                                           //
-//    Helper functions Implemetation         //
+//           Helper functions                //
 //                                           //
 //-------------------------------------------//
-
 /*
  * String to uint32 utility
  */
-uint32_t
-strtou32_s(const char buff[], uint8_t base, strsepf_result* err)
-{
-    if (err == NULL) {
-        return 0;
-    }
-    if (buff == NULL || base == 0) {
-        *err = STRSEPF_RESULT_ERR_INVALID_PARAMETER;
-        return 0;
-    }
-
-    char* end;
-    errno = 0;
-
-    const unsigned long ul = strtoul(buff, &end, base);
-    if (end == buff) {
-        *err = STRSEPF_RESULT_ERR_STRTOI_NOT_A_DECIMAL; //< not a decimal number
-
-    } else if ('\0' != *end) {
-        *err = STRSEPF_RESULT_ERR_STRTOI_EXTRA_CHAR; //< extra characters at end of input
-
-    } else if (ERANGE == errno) {
-        *err = STRSEPF_RESULT_ERR_STRTOI_OUT_OF_RANGE; //< out of range of type u long
-
-    } else if (ul > UINT32_MAX) {
-        *err = STRSEPF_RESULT_ERR_STRTOI_OUT_OF_RANGE; //< greater than MAX
-
-    } else {
-        *err = STRSEPF_RESULT_OK; //< ok
-    }
-    return (uint32_t)ul;
-}
+STRSEPF_API uint32_t
+strtou32_s(const char* buff, uint8_t base, strsepf_result* err);
 
 /*
  * String to int32 utility
  */
-int32_t
-strto32_s(const char buff[], uint8_t base, strsepf_result* err)
-{
-    if (err == NULL) {
-        return 0;
-    }
-    if (buff == NULL || base == 0) {
-        *err = STRSEPF_RESULT_ERR_INVALID_PARAMETER;
-        return 0;
-    }
-
-    char* end;
-    errno = 0;
-
-    const long sl = strtoul(buff, &end, base);
-    if (end == buff) {
-        *err = STRSEPF_RESULT_ERR_STRTOI_NOT_A_DECIMAL; //< not a decimal number
+STRSEPF_API int32_t
+strto32_s(const char* buff, uint8_t base, strsepf_result* err);
 
-    } else if ('\0' != *end) {
-        *err = STRSEPF_RESULT_ERR_STRTOI_EXTRA_CHAR; //< extra characters at end of input
+/*
+ * Evaluate a predicate on a converted number.
+ */
+STRSEPF_API bool
+strsepf_predicate_number(strsepf_predicate const* predicate, int64_t value);
 
-    } else if (ERANGE == errno) {
-        *err = STRSEPF_RESULT_ERR_STRTOI_OUT_OF_RANGE; //< out of range of type u long
+/*
+ * Evaluate a predicate on a string token.
+ */
+STRSEPF_API bool
+strsepf_predicate_string(strsepf_predicate const* predicate, char const* token);
 
-    } else if (sl > INT32_MAX) {
-        *err = STRSEPF_RESULT_ERR_STRTOI_OUT_OF_RANGE; //< greater than MAX
+/*
+ * Instruction set of the selected kernels.
+ */
+STRSEPF_API strsepf_simd
+strsepf_simd_level(void);
 
-    } else if (sl < INT32_MIN) {
-        *err = STRSEPF_RESULT_ERR_STRTOI_OUT_OF_RANGE; //< less than MIN
+/*
+ * Select the best kernels supported by the CPU, up to `max`. Mostly useful for
+ * testing and benchmarking.
+ *
+ * RETURNS:
+ *  The instruction set of the selected kernels.
+ */
+STRSEPF_API strsepf_simd
+strsepf_simd_limit(strsepf_simd max);
 
-    } else {
-        *err = STRSEPF_RESULT_OK; //< ok
-    }
-    return (int32_t)sl;
+#ifdef __cplusplus
 }
+#endif
@@ -0,0 +1,371 @@
+/* +------------------------------------------------------+
+ * | strsepf.hpp                                          |
+ * | C++20 coroutine interface: parse the records of an   |
+ * | asynchronous byte source as they complete.           |
+ * |                                                      |
+ * +------------------------------------------------------+
+ * |                                        G. Berthiaume |
+ * |                                          MIT licence |
+ * |                                                 2019 |
+ * +------------------------------------------------------+
+ */
+#pragma once
+
+//-------------------------------------------//
+//                                           //
+//                Includes                   //
+//                                           //
+//-------------------------------------------//
+#include <coroutine>   //< C++20 : coroutine_handle
+#include <cstddef>     //< cstdlib : size_t
+#include <cstdint>     //< cstdlib : *int*_t
+#include <cstring>     //< cstdlib : memchr, memmove
+#include <exception>   //< exception_ptr
+#include <span>        //< C++20 : span
+#include <string_view> //< string_view
+#include <tuple>       //< tuple, apply
+#include <type_traits> //< is_same_v, type_identity_t
+#include <utility>     //< exchange
+
+#include "strsepf.h"
+
+namespace strsepf_async {
+
+//-------------------------------------------//
+//                                           //
+//             Definitions                   //
+//                                           //
+//-------------------------------------------//
+
+/*
+ * An asynchronous byte source: `co_await source.read(buffer)` fills the
+ * beginning of `buffer` and returns the number of bytes read, 0 at the end of
+ * the stream.
+ */
+template<class S>
+concept async_byte_source = requires(S& source, std::span<char> buffer) {
+    { source.read(buffer) };
+};
+
+/*
+ * A format checked at compile time against the types of the fields it stores:
+ * `int32_t` for %d %i, `uint32_t` for %u %x %o %b, `std::string_view` for %s.
+ * The `?` predicates, %k and the repeated groups are not supported: their
+ * arguments aren't fields.
+ */
+template<class... Ts>
+class format
+{
+  public:
+    template<std::size_t N>
+    consteval format(char const (&fmt)[N])
+      : str_(fmt)
+    {
+        check_(std::string_view(fmt, N - 1));
+    }
+
+    constexpr char const* c_str() const { return str_; }
+
+  private:
+    static consteval void check_(std::string_view fmt)
+    {
+        char const  types[] = { type_of_<Ts>()... , '\0' };
+        std::size_t nFields = 0;
+        for (std::size_t i = 0; i < fmt.size(); i++) {
+            if (fmt[i] != '%') {
+                continue;
+            }
+            if (++i < fmt.size() && fmt[i] == '%') {
+                continue; //< Literal %
+            }
+
+            bool noAssign = false;
+            for (; i < fmt.size() && (fmt[i] == '*' || (fmt[i] >= '0' && fmt[i] <= '9')); i++) {
+                if (fmt[i] == '*') {
+                    noAssign = true;
+                    continue;
+                }
+                if (fmt[i] == '0') {
+                    throw "strsepf_async::format: a width can't start with 0";
+                }
+                std::uint64_t width = 0;
+                for (; i < fmt.size() && fmt[i] >= '0' && fmt[i] <= '9'; i++) {
+                    width = width * 10 + static_cast<std::uint64_t>(fmt[i] - '0');
+                    if (width > UINT32_MAX) {
+                        throw "strsepf_async::format: width out of range";
+                    }
+                }
+                i--;
+            }
+            if (i == fmt.size() || fmt[i] == '?' || fmt[i] == '{' || fmt[i] == 'k') {
+                throw "strsepf_async::format: unsupported specifier";
+            }
+            if (noAssign) {
+                continue;
+            }
+
+            char const type = (fmt[i] == 'd' || fmt[i] == 'i')                     ? 'd'
+                              : (fmt[i] == 'u' || fmt[i] == 'x' || fmt[i] == 'o' ||
+                                 fmt[i] == 'b')                                     ? 'u'
+                              : (fmt[i] == 's')                                     ? 's'
+                                                                                    : '\0';
+            if (type == '\0') {
+                throw "strsepf_async::format: unknown specifier";
+            }
+            if (nFields == sizeof...(Ts) || types[nFields] != type) {
+                throw "strsepf_async::format: the field types don't match the format";
+            }
+            nFields++;
+        }
+        if (nFields != sizeof...(Ts)) {
+            throw "strsepf_async::format: the field types don't match the format";
+        }
+    }
+
+    template<class T>
+    static consteval char type_of_()
+    {
+        if constexpr (std::is_same_v<T, int32_t>) {
+            return 'd';
+        } else if constexpr (std::is_same_v<T, uint32_t>) {
+            return 'u';
+        } else if constexpr (std::is_same_v<T, std::string_view>) {
+            return 's';
+        } else {
+            static_assert(!sizeof(T), "strsepf_async::format: unsupported field type");
+        }
+    }
+
+    char const* str_;
+};
+
+/*
+ * A parsed record.
+ * The `std::string_view` fields point into the stream buffer: they are valid
+ * until the generator is resumed.
+ */
+template<class... Ts>
+struct record
+{
+    int16_t           result; //< Return value of `strsepf` (number of fields or error)
+    std::tuple<Ts...> fields;
+};
+
+/*
+ * An asynchronous generator: the consumer awaits `next()`, the producer
+ * coroutine awaits its source and `co_yield`s the values.
+ */
+template<class T>
+class async_generator
+{
+  public:
+    struct promise_type;
+    using handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type
+    {
+        T const*                value = nullptr;
+        std::coroutine_handle<> consumer;
+        std::exception_ptr      error;
+
+        async_generator get_return_object() { return async_generator(handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto                final_suspend() noexcept { return to_consumer_{}; }
+        auto                yield_value(T const& v) noexcept
+        {
+            value = &v;
+            return to_consumer_{};
+        }
+        void return_void() noexcept { value = nullptr; }
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+    };
+
+    explicit async_generator(handle h)
+      : h_(h)
+    {}
+    async_generator(async_generator&& other) noexcept
+      : h_(std::exchange(other.h_, {}))
+    {}
+    async_generator& operator=(async_generator&& other) noexcept
+    {
+        if (this != &other) {
+            destroy_();
+            h_ = std::exchange(other.h_, {});
+        }
+        return *this;
+    }
+    async_generator(async_generator const&) = delete;
+    async_generator& operator=(async_generator const&) = delete;
+    ~async_generator() { destroy_(); }
+
+    /*
+     * `co_await gen.next()` returns the next value, or nullptr at the end.
+     */
+    auto next()
+    {
+        struct awaiter
+        {
+            handle h;
+
+            bool await_ready() const noexcept { return !h || h.done(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept
+            {
+                h.promise().consumer = consumer;
+                return h;
+            }
+            T const* await_resume()
+            {
+                if (!h || h.done()) {
+                    if (h && h.promise().error) {
+                        std::rethrow_exception(std::exchange(h.promise().error, {}));
+                    }
+                    return nullptr;
+                }
+                return h.promise().value;
+            }
+        };
+        return awaiter{ h_ };
+    }
+
+  private:
+    // Suspend the producer and resume the consumer
+    struct to_consumer_
+    {
+        bool                    await_ready() const noexcept { return false; }
+        std::coroutine_handle<> await_suspend(handle h) noexcept { return h.promise().consumer; }
+        void                    await_resume() const noexcept {}
+    };
+
+    void destroy_()
+    {
+        if (h_) {
+            h_.destroy();
+        }
+    }
+
+    handle h_;
+};
+
+//-------------------------------------------//
+//                                           //
+//          Internal definitions             //
+//                                           //
+//-------------------------------------------//
+
+namespace detail {
+
+// What `strsepf` stores for a field type.
+template<class T>
+using storage_t = std::conditional_t<std::is_same_v<T, std::string_view>, char*, T>;
+
+/*
+ * Parse one '\0' terminated record into `out`.
+ */
+template<class... Ts>
+int16_t
+parse_record(char* line, char const* fmt, record<Ts...>& out)
+{
+    std::tuple<storage_t<Ts>...> raw{};
+    out.result = std::apply([&](auto&... field) { return ::strsepf(line, fmt, &field...); }, raw);
+
+    [&]<std::size_t... I>(std::index_sequence<I...>) {
+        ((std::get<I>(out.fields) = [](auto value) {
+             if constexpr (std::is_pointer_v<decltype(value)>) {
+                 return value == nullptr ? std::string_view() : std::string_view(value);
+             } else {
+                 return value;
+             }
+         }(std::get<I>(raw))),
+         ...);
+    }(std::index_sequence_for<Ts...>{});
+    return out.result;
+}
+
+} // namespace detail
+
+//-------------------------------------------//
+//                                           //
+//               Interface                   //
+//                                           //
+//-------------------------------------------//
+
+/*
+ * `records` parses every line (record ending with '\n') of an asynchronous byte
+ * source with `strsepf`, and yields the records as they complete.
+ *
+ * The coroutine frame is the whole per-stream state: `buffer` receives the reads,
+ * the complete records are parsed in place, and only the incomplete record at the
+ * end of a read is moved to the front of `buffer` before the next read. A single
+ * event loop thread can therefore serve many slow streams, each with one buffer
+ * as large as their longest record.
+ *
+ * A record that doesn't match the format is yielded with its negative `result`,
+ * and the stream goes on. A record longer than `buffer` is yielded with
+ * STRSEPF_RESULT_ERR_RECORD_TOO_LONG, and the stream goes on after its '\n'.
+ *
+ * ARGUMENTS:
+ *  @param: source - Asynchronous byte source. Must outlive the generator.
+ *  @param: buffer - Read buffer, larger than the longest record. Must outlive the generator.
+ *  @param: fmt    - `strsepf` format of a record.
+ *
+ * USAGE EXAMPLE:
+ *
+ *    auto gen = strsepf_async::records<uint32_t, std::string_view>(socket, buffer, "%u,%s");
+ *    while (auto const* r = co_await gen.next()) {
+ *        if (r->result == 2) {
+ *            auto const& [id, name] = r->fields;
+ *        }
+ *    }
+ */
+template<class... Ts, async_byte_source Source>
+async_generator<record<Ts...>>
+records(Source& source, std::span<char> buffer, format<std::type_identity_t<Ts>...> fmt)
+{
+    if (buffer.size() < 2) {
+        co_return;
+    }
+
+    record<Ts...> out{};
+    std::size_t   len = 0;      //< Bytes in `buffer`, starting with an incomplete record
+    bool          skip = false; //< Dropping the end of a record longer than `buffer`
+    for (;;) {
+        std::size_t const n = co_await source.read(buffer.subspan(len, buffer.size() - 1 - len));
+        bool const        eof = (n == 0);
+        len += n;
+
+        // Parse the complete records in place
+        char*       begin = buffer.data();
+        char* const end = buffer.data() + len;
+        for (char* nl; (nl = static_cast<char*>(std::memchr(begin, '\n', end - begin))) != nullptr;
+             begin = nl + 1) {
+            *nl = '\0';
+            if (!std::exchange(skip, false)) {
+                detail::parse_record(begin, fmt.c_str(), out);
+                co_yield out;
+            }
+        }
+
+        len = static_cast<std::size_t>(end - begin);
+        if (eof) {
+            if (len > 0 && !skip) {
+                begin[len] = '\0'; //< Last record without '\n'
+                detail::parse_record(begin, fmt.c_str(), out);
+                co_yield out;
+            }
+            co_return;
+        }
+        if (len == buffer.size() - 1) {
+            if (!skip) {
+                out = {};
+                out.result = STRSEPF_RESULT_ERR_RECORD_TOO_LONG;
+                co_yield out;
+            }
+            skip = true;
+            len = 0;
+            continue;
+        }
+        std::memmove(buffer.data(), begin, len);
+    }
+}
+
+} // namespace strsepf_async
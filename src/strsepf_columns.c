@@ -0,0 +1,192 @@
+/* +------------------------------------------------------+
+ * | strsepf_columns.c                                    |
+ * | Columnar ingestion of numeric CSV: tokenize a block  |
+ * | of rows, then convert a whole column at once, with   |
+ * | the SIMD conversion kernel.                          |
+ * |                                                      |
+ * +------------------------------------------------------+
+ * |                                        G. Berthiaume |
+ * |                                          MIT licence |
+ * |                                                 2019 |
+ * +------------------------------------------------------+
+ */
+#include "strsepf_columns.h"
+
+//-------------------------------------------//
+//                                           //
+//                Includes                   //
+//                                           //
+//-------------------------------------------//
+#include <stdbool.h> //< cstdlib : bool
+#include <string.h>  //< cstdlib : memcpy, memset
+
+#include "strsepf_simd.h"
+
+//-------------------------------------------//
+//                                           //
+//          Internal definitions             //
+//                                           //
+//-------------------------------------------//
+
+// Number of rows converted together by the conversion kernel.
+#define STRSEPF_COLUMN_BLOCK STRSEPF_SIMD_LANES
+
+// Longest number converted by the vector kernel: 9 digits always fit an int32_t.
+#define STRSEPF_COLUMN_MAX_DIGITS 9
+
+static void
+strsepf_column_convert_(char* const    column[],
+                        size_t         nRows,
+                        bool           isSigned,
+                        uint32_t       values[],
+                        strsepf_result errs[]);
+
+//-------------------------------------------//
+//                                           //
+//              Implementation               //
+//                                           //
+//-------------------------------------------//
+
+size_t
+strsepf_columns_split(char*          rows[],
+                      size_t         nRows,
+                      char           delim,
+                      char*          fields[],
+                      size_t         nCols,
+                      strsepf_result errs[])
+{
+    if (rows == NULL || fields == NULL || errs == NULL || nCols == 0 || delim == '\0') {
+        return 0;
+    }
+
+    char const termination[] = { delim, '\0' };
+    size_t     count = 0;
+    for (size_t row = 0; row < nRows; row++) {
+        char*  str = rows[row];
+        size_t col = 0;
+        for (; col < nCols && str != NULL; col++) {
+            fields[col * nRows + row] = strsepf_tokenize_(&str, termination);
+        }
+
+        if (col != nCols || str != NULL) {
+            errs[row] = STRSEPF_RESULT_ERR_INPUT_DOESNT_MATCH_FORMAT;
+            for (col = 0; col < nCols; col++) {
+                fields[col * nRows + row] = NULL;
+            }
+        } else {
+            errs[row] = STRSEPF_RESULT_OK;
+            count++;
+        }
+    }
+    return count;
+}
+
+void
+strsepf_column_to32(char* const column[], size_t nRows, int32_t values[], strsepf_result errs[])
+{
+    if (column == NULL || values == NULL || errs == NULL) {
+        return;
+    }
+    strsepf_column_convert_(column, nRows, true, (uint32_t*)(void*)values, errs);
+}
+
+void
+strsepf_column_tou32(char* const column[], size_t nRows, uint32_t values[], strsepf_result errs[])
+{
+    if (column == NULL || values == NULL || errs == NULL) {
+        return;
+    }
+    strsepf_column_convert_(column, nRows, false, values, errs);
+}
+
+//-------------------------------------------//
+//                                           //
+//    Internal functions Implemetation       //
+//                                           //
+//-------------------------------------------//
+
+/*
+ * Scalar conversion of one row.
+ */
+static void
+strsepf_column_convert_one_(char const* token, bool isSigned, uint32_t* value, strsepf_result* err)
+{
+    if (*err < STRSEPF_RESULT_OK) {
+        return;
+    }
+    if (token == NULL) {
+        *err = STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+        return;
+    }
+
+    strsepf_result rc;
+    if (isSigned) {
+        *value = (uint32_t)strto32_s(token, 10, &rc);
+    } else {
+        *value = strtou32_s(token, 10, &rc);
+    }
+    if (rc < STRSEPF_RESULT_OK) {
+        *err = rc;
+    }
+}
+
+/*
+ * Convert a column, STRSEPF_COLUMN_BLOCK rows at a time with the conversion kernel.
+ *
+ * Every number of the block is right-aligned in a 16 bytes lane padded with '0',
+ * then all the lanes are validated and converted together (see `strsepf_simd.c`).
+ * The last block is padded with empty lanes. Rows that don't fit the fast path
+ * (empty, sign other than a leading '-' on a signed column, more than 9 digits, any
+ * other character) fall back to the scalar conversion, so the results and errors
+ * are the same.
+ */
+static void
+strsepf_column_convert_(char* const    column[],
+                        size_t         nRows,
+                        bool           isSigned,
+                        uint32_t       values[],
+                        strsepf_result errs[])
+{
+    for (size_t row = 0; row < nRows; row += STRSEPF_COLUMN_BLOCK) {
+        size_t const nBlock = (nRows - row < STRSEPF_COLUMN_BLOCK) ? nRows - row : STRSEPF_COLUMN_BLOCK;
+
+        _Alignas(32) char lanes[STRSEPF_COLUMN_BLOCK][STRSEPF_SIMD_LANE_SIZE];
+        bool              negative[STRSEPF_COLUMN_BLOCK];
+        bool              fast[STRSEPF_COLUMN_BLOCK];
+
+        // Gather the digit spans of the block
+        memset(lanes, '0', sizeof(lanes));
+        for (size_t i = 0; i < nBlock; i++) {
+            char const* token = column[row + i];
+            fast[i] = (errs[row + i] == STRSEPF_RESULT_OK && token != NULL);
+            negative[i] = false;
+            if (!fast[i]) {
+                continue;
+            }
+            if (isSigned && token[0] == '-') {
+                negative[i] = true;
+                token++;
+            }
+            size_t len = 0;
+            while (len <= STRSEPF_COLUMN_MAX_DIGITS && token[len] != '\0') {
+                len++;
+            }
+            if (len == 0 || len > STRSEPF_COLUMN_MAX_DIGITS) {
+                fast[i] = false;
+                continue;
+            }
+            memcpy(&lanes[i][STRSEPF_SIMD_LANE_SIZE - len], token, len);
+        }
+
+        uint32_t       out[STRSEPF_COLUMN_BLOCK];
+        uint32_t const valid = strsepf_convert_lanes_(lanes, out);
+
+        for (size_t i = 0; i < nBlock; i++) {
+            if (!fast[i] || (valid & (1u << i)) == 0) {
+                strsepf_column_convert_one_(column[row + i], isSigned, &values[row + i], &errs[row + i]);
+                continue;
+            }
+            values[row + i] = negative[i] ? (uint32_t)(-(int32_t)out[i]) : out[i];
+        }
+    }
+}
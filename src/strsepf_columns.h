@@ -0,0 +1,92 @@
+/* +------------------------------------------------------+
+ * | strsepf_columns.h                                    |
+ * | Columnar ingestion of numeric CSV: tokenize a block  |
+ * | of rows, then convert a whole column at once, with   |
+ * | the SIMD conversion kernel.                          |
+ * |                                                      |
+ * +------------------------------------------------------+
+ * |                                        G. Berthiaume |
+ * |                                          MIT licence |
+ * |                                                 2019 |
+ * +------------------------------------------------------+
+ */
+#pragma once
+
+//-------------------------------------------//
+//                                           //
+//                Includes                   //
+//                                           //
+//-------------------------------------------//
+#include <stddef.h> //< cstdlib : size_t
+#include <stdint.h> //< cstdlib : *int*_t
+
+#include "strsepf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//-------------------------------------------//
+//                                           //
+//               Interface                   //
+//                                           //
+//-------------------------------------------//
+
+/*
+ * `strsepf_columns_split` tokenizes a block of rows into columns.
+ *
+ * Every row shall have exactly `nCols` fields separated by `delim`. The fields are
+ * stored column-major: `fields[col * nRows + row]`, so one column is a contiguous
+ * array that can be given to `strsepf_column_to32` or `strsepf_column_tou32`.
+ *
+ * ARGUMENTS:
+ *  @param: rows   - Mutable rows (will be destroyed).
+ *  @param: nRows  - Number of rows.
+ *  @param: delim  - Field delimiter (eg ',').
+ *  @param: fields - Tokens (output, nRows * nCols elements).
+ *  @param: nCols  - Number of fields of a row.
+ *  @param: errs   - Per-row result (output, nRows elements). A row without exactly
+ *                   `nCols` fields is STRSEPF_RESULT_ERR_INPUT_DOESNT_MATCH_FORMAT and
+ *                   its fields are NULL.
+ *
+ * RETURNS:
+ *  Will return the number of rows without error.
+ *
+ * USAGE EXAMPLE:
+ *
+ *    char*          rows[] = { line0, line1, ... };  //< "12,-4,7"
+ *    char*          fields[3 * N];
+ *    int32_t        col1[N];
+ *    strsepf_result errs[N];
+ *
+ *    strsepf_columns_split(rows, N, ',', fields, 3, errs);
+ *    strsepf_column_to32(&fields[1 * N], N, col1, errs);
+ */
+STRSEPF_API size_t
+strsepf_columns_split(char*          rows[],
+                      size_t         nRows,
+                      char           delim,
+                      char*          fields[],
+                      size_t         nCols,
+                      strsepf_result errs[]);
+
+/*
+ * Convert a column of decimal numbers to int32_t.
+ *
+ * The result of every row is the same as `strto32_s(column[row], 10, ...)`.
+ * Rows already in error (errs[row] < 0) are skipped, and a conversion error is
+ * only stored in errs[row], so the errors of several columns can be accumulated.
+ */
+STRSEPF_API void
+strsepf_column_to32(char* const column[], size_t nRows, int32_t values[], strsepf_result errs[]);
+
+/*
+ * Convert a column of decimal numbers to uint32_t.
+ * Same as `strsepf_column_to32`, with the result of `strtou32_s(column[row], 10, ...)`.
+ */
+STRSEPF_API void
+strsepf_column_tou32(char* const column[], size_t nRows, uint32_t values[], strsepf_result errs[]);
+
+#ifdef __cplusplus
+}
+#endif
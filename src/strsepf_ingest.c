@@ -0,0 +1,515 @@
+/* +------------------------------------------------------+
+ * | strsepf_ingest.c                                     |
+ * | Bulk file ingestion front end: keeps several large   |
+ * | reads in flight across files (io_uring on Linux,     |
+ * | pread elsewhere) and hands complete records to a     |
+ * | callback.                                            |
+ * |                                                      |
+ * +------------------------------------------------------+
+ * |                                        G. Berthiaume |
+ * |                                          MIT licence |
+ * |                                                 2019 |
+ * +------------------------------------------------------+
+ */
+
+// NOTE:
+// This file uses POSIX 2008 functions (pread, clock_gettime) and, on Linux, the
+// io_uring system calls.
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include "strsepf_ingest.h"
+
+//-------------------------------------------//
+//                                           //
+//                Includes                   //
+//                                           //
+//-------------------------------------------//
+#include <errno.h>     //< cstdlib : errno
+#include <fcntl.h>     //< posix   : open
+#include <stdatomic.h> //< cstdlib : atomic_load_explicit
+#include <stdbool.h>   //< cstdlib : bool
+#include <stddef.h>    //< cstdlib : size_t
+#include <stdint.h>    //< cstdlib : uint64_t
+#include <string.h>    //< cstdlib : memchr, memmove
+#include <sys/uio.h>   //< posix   : struct iovec
+#include <time.h>      //< posix   : clock_gettime
+#include <unistd.h>    //< posix   : pread, close
+
+#if defined(__linux__) && !defined(STRSEPF_NO_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define STRSEPF_HAS_IO_URING 1
+#include <linux/io_uring.h> //< linux : io_uring ABI
+#include <sys/mman.h>       //< posix : mmap
+#include <sys/syscall.h>    //< linux : __NR_io_uring_*
+#endif
+#endif
+
+//-------------------------------------------//
+//                                           //
+//          Internal definitions             //
+//                                           //
+//-------------------------------------------//
+
+// Attempts of a submission interrupted by a signal or short of kernel resources.
+#define STRSEPF_INGEST_ENTER_ATTEMPTS 8
+
+/*
+ * A read buffer, bound to one file at a time.
+ */
+typedef struct
+{
+    size_t          file;   //< Index of the file, SIZE_MAX if free
+    int             fd;
+    uint64_t        offset; //< Offset of the next read
+    size_t          carry;  //< Incomplete record at the start of the buffer
+    struct iovec    iov;    //< Current read
+    struct timespec start;
+} strsepf_ingest_slot_;
+
+/*
+ * Read back end state.
+ */
+typedef struct
+{
+    strsepf_ingest_slot_ slots[STRSEPF_INGEST_MAX_INFLIGHT];
+    size_t               nSlots;
+    size_t               pending[STRSEPF_INGEST_MAX_INFLIGHT]; //< pread: FIFO of submitted reads
+    size_t               pendingHead;
+    size_t               nPending;
+    bool                 ioUring;
+#ifdef STRSEPF_HAS_IO_URING
+    int                  ringFd;
+    void*                sqRing;
+    size_t               sqRingSize;
+    void*                cqRing;
+    size_t               cqRingSize;
+    struct io_uring_sqe* sqes;
+    size_t               sqesSize;
+    unsigned*            sqHead;
+    unsigned*            sqTail;
+    unsigned*            sqMask;
+    unsigned*            sqArray;
+    unsigned*            cqHead;
+    unsigned*            cqTail;
+    unsigned*            cqMask;
+    struct io_uring_cqe* cqes;
+#endif
+} strsepf_ingest_state_;
+
+static bool
+strsepf_ingest_uring_init_(strsepf_ingest_state_* state, unsigned entries);
+
+static void
+strsepf_ingest_uring_exit_(strsepf_ingest_state_* state);
+
+static int
+strsepf_ingest_submit_(strsepf_ingest_state_* state, size_t slot);
+
+static bool
+strsepf_ingest_wait_(strsepf_ingest_state_* state, size_t* slot, ssize_t* res);
+
+static bool
+strsepf_ingest_open_(strsepf_ingest_config const* config,
+                     strsepf_ingest_state_*       state,
+                     size_t                       slot,
+                     char const* const            paths[],
+                     size_t*                      nextFile,
+                     size_t                       nFiles,
+                     strsepf_ingest_stats         stats[]);
+
+static void
+strsepf_ingest_close_(strsepf_ingest_state_* state, size_t slot, strsepf_ingest_stats stats[]);
+
+static int
+strsepf_ingest_syscall_enter_(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags);
+
+strsepf_ingest_enter_fn_ strsepf_ingest_enter_ = strsepf_ingest_syscall_enter_;
+
+//-------------------------------------------//
+//                                           //
+//              Implementation               //
+//                                           //
+//-------------------------------------------//
+
+int32_t
+strsepf_ingest(strsepf_ingest_config const* config,
+               char const* const            paths[],
+               size_t                       nFiles,
+               strsepf_ingest_stats         stats[])
+{
+    if (config == NULL || paths == NULL || stats == NULL || config->buffers == NULL ||
+        config->onRecord == NULL || config->bufferSize < 2 || config->nInflight == 0 ||
+        config->nInflight > STRSEPF_INGEST_MAX_INFLIGHT) {
+        return STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+    }
+
+    for (size_t i = 0; i < nFiles; i++) {
+        memset(&stats[i], 0, sizeof(stats[i]));
+        stats[i].result = STRSEPF_RESULT_ERR_IO; //< Until the file is ingested
+        stats[i].errnum = ECANCELED;
+    }
+
+    strsepf_ingest_state_ state;
+    memset(&state, 0, sizeof(state));
+    state.nSlots = config->nInflight;
+    for (size_t i = 0; i < state.nSlots; i++) {
+        state.slots[i].file = SIZE_MAX;
+        state.slots[i].fd = -1;
+    }
+
+    if (config->backend != STRSEPF_INGEST_PREAD) {
+        state.ioUring = strsepf_ingest_uring_init_(&state, (unsigned)state.nSlots);
+        if (!state.ioUring && config->backend == STRSEPF_INGEST_IO_URING) {
+            return STRSEPF_RESULT_ERR_IO;
+        }
+    }
+
+    size_t  nextFile = 0;
+    size_t  active = 0;
+    int32_t count = 0;
+    for (size_t i = 0; i < state.nSlots; i++) {
+        if (strsepf_ingest_open_(config, &state, i, paths, &nextFile, nFiles, stats)) {
+            active++;
+        }
+    }
+
+    while (active > 0) {
+        size_t  i;
+        ssize_t res;
+        if (!strsepf_ingest_wait_(&state, &i, &res)) {
+            break; //< io_uring failure: the remaining files keep their error
+        }
+
+        strsepf_ingest_slot_* slot = &state.slots[i];
+        strsepf_ingest_stats* stat = &stats[slot->file];
+        char*                 buffer = &config->buffers[i * config->bufferSize];
+
+        if (res < 0) {
+            stat->result = STRSEPF_RESULT_ERR_IO;
+            stat->errnum = (int)-res;
+
+        } else if (res == 0) {
+            // End of file: the last record may not have a delimiter
+            if (slot->carry > 0) {
+                buffer[slot->carry] = '\0';
+                config->onRecord(buffer, slot->file, config->ctx);
+                stat->records++;
+            }
+            stat->result = STRSEPF_RESULT_OK;
+            count++;
+
+        } else {
+            // Hand the complete records, keep the incomplete one
+            stat->bytes += (uint64_t)res;
+            slot->offset += (uint64_t)res;
+
+            char*       record = buffer;
+            char* const end = &buffer[slot->carry + (size_t)res];
+            char*       nl;
+            while ((nl = memchr(record, '\n', (size_t)(end - record))) != NULL) {
+                *nl = '\0';
+                config->onRecord(record, slot->file, config->ctx);
+                stat->records++;
+                record = nl + 1;
+            }
+            slot->carry = (size_t)(end - record);
+            memmove(buffer, record, slot->carry);
+
+            if (slot->carry == config->bufferSize - 1) {
+                stat->result = STRSEPF_RESULT_ERR_RECORD_TOO_LONG;
+            } else {
+                slot->iov.iov_base = &buffer[slot->carry];
+                slot->iov.iov_len = config->bufferSize - 1 - slot->carry; //< Room for the '\0'
+                int const errnum = strsepf_ingest_submit_(&state, i);
+                if (errnum == 0) {
+                    continue; //< Next read of the same file
+                }
+                stat->result = STRSEPF_RESULT_ERR_IO;
+                stat->errnum = errnum;
+            }
+        }
+
+        // This file is done: reuse its buffer for the next one
+        strsepf_ingest_close_(&state, i, stats);
+        active--;
+        if (strsepf_ingest_open_(config, &state, i, paths, &nextFile, nFiles, stats)) {
+            active++;
+        }
+    }
+
+    for (size_t i = 0; i < state.nSlots; i++) {
+        if (state.slots[i].file != SIZE_MAX) {
+            strsepf_ingest_close_(&state, i, stats);
+        }
+    }
+    strsepf_ingest_uring_exit_(&state);
+    return count;
+}
+
+//-------------------------------------------//
+//                                           //
+//    Internal functions Implemetation       //
+//                                           //
+//-------------------------------------------//
+
+/*
+ * Open the next file in a free buffer and submit its first read.
+ * Files that can't be opened are recorded in their stats and skipped.
+ */
+static bool
+strsepf_ingest_open_(strsepf_ingest_config const* config,
+                     strsepf_ingest_state_*       state,
+                     size_t                       slot,
+                     char const* const            paths[],
+                     size_t*                      nextFile,
+                     size_t                       nFiles,
+                     strsepf_ingest_stats         stats[])
+{
+    while (*nextFile < nFiles) {
+        size_t const          file = (*nextFile)++;
+        strsepf_ingest_slot_* s = &state->slots[slot];
+
+        memset(&stats[file], 0, sizeof(stats[file]));
+        clock_gettime(CLOCK_MONOTONIC, &s->start);
+
+        s->fd = (paths[file] == NULL) ? -1 : open(paths[file], O_RDONLY | O_CLOEXEC);
+        if (s->fd < 0) {
+            stats[file].result = STRSEPF_RESULT_ERR_IO;
+            stats[file].errnum = (paths[file] == NULL) ? EINVAL : errno;
+            continue;
+        }
+#ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(s->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+        s->file = file;
+        s->offset = 0;
+        s->carry = 0;
+        s->iov.iov_base = &config->buffers[slot * config->bufferSize];
+        s->iov.iov_len = config->bufferSize - 1; //< Room for the '\0'
+        int const errnum = strsepf_ingest_submit_(state, slot);
+        if (errnum == 0) {
+            return true;
+        }
+        stats[file].result = STRSEPF_RESULT_ERR_IO;
+        stats[file].errnum = errnum;
+        strsepf_ingest_close_(state, slot, stats);
+    }
+    return false;
+}
+
+/*
+ * Close the file of a buffer and record its duration.
+ */
+static void
+strsepf_ingest_close_(strsepf_ingest_state_* state, size_t slot, strsepf_ingest_stats stats[])
+{
+    strsepf_ingest_slot_* s = &state->slots[slot];
+
+    if (s->file != SIZE_MAX) {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        stats[s->file].nsec = (uint64_t)(now.tv_sec - s->start.tv_sec) * 1000000000u +
+                              (uint64_t)now.tv_nsec - (uint64_t)s->start.tv_nsec;
+    }
+    if (s->fd >= 0) {
+        close(s->fd);
+    }
+    s->fd = -1;
+    s->file = SIZE_MAX;
+}
+
+/*
+ * Queue the read of a buffer.
+ *
+ * RETURNS:
+ *  0 when the read is in flight, or the errno of the failure. A read that
+ *  failed isn't left in the submission ring: its buffer can be reused.
+ */
+static int
+strsepf_ingest_submit_(strsepf_ingest_state_* state, size_t slot)
+{
+#ifdef STRSEPF_HAS_IO_URING
+    if (state->ioUring) {
+        strsepf_ingest_slot_* s = &state->slots[slot];
+        unsigned const        tail = *state->sqTail;
+        unsigned const        index = tail & *state->sqMask;
+        struct io_uring_sqe*  sqe = &state->sqes[index];
+
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READV;
+        sqe->fd = s->fd;
+        sqe->addr = (uint64_t)(uintptr_t)&s->iov;
+        sqe->len = 1;
+        sqe->off = s->offset;
+        sqe->user_data = slot;
+        state->sqArray[index] = index;
+        atomic_store_explicit((_Atomic unsigned*)state->sqTail, tail + 1, memory_order_release);
+
+        int rc;
+        int attempts = STRSEPF_INGEST_ENTER_ATTEMPTS;
+        do {
+            rc = strsepf_ingest_enter_(state->ringFd, 1, 0, 0);
+        } while (rc < 0 && (errno == EINTR || errno == EAGAIN) && --attempts > 0);
+        int const errnum = (rc < 0) ? errno : EIO;
+
+        // The head tells if the kernel consumed the read, whatever `enter` returned
+        if (atomic_load_explicit((_Atomic unsigned*)state->sqHead, memory_order_acquire) != tail) {
+            return 0;
+        }
+        // Not consumed: take it back. Without SQPOLL, the kernel only reads the
+        // submission ring in `enter`, so the next `enter` won't see it.
+        atomic_store_explicit((_Atomic unsigned*)state->sqTail, tail, memory_order_release);
+        return errnum;
+    }
+#endif
+
+    state->pending[(state->pendingHead + state->nPending) % state->nSlots] = slot;
+    state->nPending++;
+    return 0;
+}
+
+/*
+ * Wait for the next completed read.
+ */
+static bool
+strsepf_ingest_wait_(strsepf_ingest_state_* state, size_t* slot, ssize_t* res)
+{
+#ifdef STRSEPF_HAS_IO_URING
+    if (state->ioUring) {
+        unsigned const head = *state->cqHead;
+        while (head == atomic_load_explicit((_Atomic unsigned*)state->cqTail, memory_order_acquire)) {
+            if (strsepf_ingest_enter_(state->ringFd, 0, 1, IORING_ENTER_GETEVENTS) < 0 &&
+                errno != EINTR) {
+                return false;
+            }
+        }
+
+        struct io_uring_cqe const* cqe = &state->cqes[head & *state->cqMask];
+        *slot = (size_t)cqe->user_data;
+        *res = cqe->res;
+        atomic_store_explicit((_Atomic unsigned*)state->cqHead, head + 1, memory_order_release);
+        return true;
+    }
+#endif
+
+    if (state->nPending == 0) {
+        return false;
+    }
+    *slot = state->pending[state->pendingHead];
+    state->pendingHead = (state->pendingHead + 1) % state->nSlots;
+    state->nPending--;
+
+    strsepf_ingest_slot_* s = &state->slots[*slot];
+    do {
+        *res = pread(s->fd, s->iov.iov_base, s->iov.iov_len, (off_t)s->offset);
+    } while (*res < 0 && errno == EINTR);
+    if (*res < 0) {
+        *res = -errno;
+    }
+    return true;
+}
+
+/*
+ * Set up an io_uring instance with its submission and completion rings.
+ */
+static bool
+strsepf_ingest_uring_init_(strsepf_ingest_state_* state, unsigned entries)
+{
+#ifdef STRSEPF_HAS_IO_URING
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    state->ringFd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (state->ringFd < 0) {
+        return false; //< Not supported or not allowed: pread fallback
+    }
+
+    state->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    state->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (state->cqRingSize > state->sqRingSize) {
+            state->sqRingSize = state->cqRingSize;
+        }
+        state->cqRingSize = 0;
+    }
+
+    state->sqRing = mmap(NULL, state->sqRingSize, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, state->ringFd, IORING_OFF_SQ_RING);
+    state->cqRing = state->sqRing;
+    if (state->sqRing != MAP_FAILED && state->cqRingSize > 0) {
+        state->cqRing = mmap(NULL, state->cqRingSize, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, state->ringFd, IORING_OFF_CQ_RING);
+    }
+    state->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    state->sqes = mmap(NULL, state->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       state->ringFd, IORING_OFF_SQES);
+    if (state->sqRing == MAP_FAILED || state->cqRing == MAP_FAILED || state->sqes == MAP_FAILED) {
+        state->ioUring = true; //< Let `exit` unmap what was mapped
+        strsepf_ingest_uring_exit_(state);
+        return false;
+    }
+
+    char* sq = state->sqRing;
+    char* cq = state->cqRing;
+    state->sqHead = (unsigned*)(void*)(sq + params.sq_off.head);
+    state->sqTail = (unsigned*)(void*)(sq + params.sq_off.tail);
+    state->sqMask = (unsigned*)(void*)(sq + params.sq_off.ring_mask);
+    state->sqArray = (unsigned*)(void*)(sq + params.sq_off.array);
+    state->cqHead = (unsigned*)(void*)(cq + params.cq_off.head);
+    state->cqTail = (unsigned*)(void*)(cq + params.cq_off.tail);
+    state->cqMask = (unsigned*)(void*)(cq + params.cq_off.ring_mask);
+    state->cqes = (struct io_uring_cqe*)(void*)(cq + params.cq_off.cqes);
+    return true;
+#else
+    (void)state;
+    (void)entries;
+    return false;
+#endif
+}
+
+/*
+ * Default `strsepf_ingest_enter_`: the io_uring_enter system call.
+ */
+static int
+strsepf_ingest_syscall_enter_(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+#ifdef STRSEPF_HAS_IO_URING
+    return (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, NULL, 0);
+#else
+    (void)ringFd;
+    (void)toSubmit;
+    (void)minComplete;
+    (void)flags;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+/*
+ * Tear down the io_uring instance, if any.
+ */
+static void
+strsepf_ingest_uring_exit_(strsepf_ingest_state_* state)
+{
+#ifdef STRSEPF_HAS_IO_URING
+    if (!state->ioUring) {
+        return;
+    }
+    if (state->sqes != NULL && state->sqes != MAP_FAILED) {
+        munmap(state->sqes, state->sqesSize);
+    }
+    if (state->cqRing != NULL && state->cqRing != MAP_FAILED && state->cqRing != state->sqRing) {
+        munmap(state->cqRing, state->cqRingSize);
+    }
+    if (state->sqRing != NULL && state->sqRing != MAP_FAILED) {
+        munmap(state->sqRing, state->sqRingSize);
+    }
+    close(state->ringFd);
+    state->ioUring = false;
+#else
+    (void)state;
+#endif
+}
@@ -0,0 +1,138 @@
+/* +------------------------------------------------------+
+ * | strsepf_ingest.h                                     |
+ * | Bulk file ingestion front end: keeps several large   |
+ * | reads in flight across files (io_uring on Linux,     |
+ * | pread elsewhere) and hands complete records to a     |
+ * | callback.                                            |
+ * |                                                      |
+ * +------------------------------------------------------+
+ * |                                        G. Berthiaume |
+ * |                                          MIT licence |
+ * |                                                 2019 |
+ * +------------------------------------------------------+
+ */
+#pragma once
+
+//-------------------------------------------//
+//                                           //
+//                Includes                   //
+//                                           //
+//-------------------------------------------//
+#include <stddef.h> //< cstdlib : size_t
+#include <stdint.h> //< cstdlib : uint64_t
+
+#include "strsepf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//-------------------------------------------//
+//                                           //
+//             Definitions                   //
+//                                           //
+//-------------------------------------------//
+
+// Maximum number of reads in flight.
+#ifndef STRSEPF_INGEST_MAX_INFLIGHT
+#define STRSEPF_INGEST_MAX_INFLIGHT 64
+#endif
+
+/*
+ * Enumerates the read back ends.
+ */
+typedef enum
+{
+    STRSEPF_INGEST_AUTO,     //< io_uring when available, pread otherwise
+    STRSEPF_INGEST_IO_URING, //< io_uring only (fails if not available)
+    STRSEPF_INGEST_PREAD,    //< Blocking pread
+} strsepf_ingest_backend;
+
+/*
+ * Called for every complete record (line, without its '\n').
+ * The record is mutable and can be given to `strsepf`.
+ */
+typedef void (*strsepf_ingest_fn)(char* record, size_t file, void* ctx);
+
+/*
+ * Ingestion configuration. All the memory is provided by the caller.
+ */
+typedef struct
+{
+    char*                  buffers;    //< nInflight * bufferSize bytes
+    size_t                 bufferSize; //< Size of a read buffer (and largest record)
+    size_t                 nInflight;  //< Number of reads in flight, one file each
+    strsepf_ingest_backend backend;
+    strsepf_ingest_fn      onRecord;
+    void*                  ctx;        //< Given to `onRecord`
+} strsepf_ingest_config;
+
+/*
+ * Per-file statistics.
+ */
+typedef struct
+{
+    uint64_t bytes;   //< Number of bytes read
+    uint64_t records; //< Number of records handed to `onRecord`
+    uint64_t nsec;    //< Time from open to end of file
+    int16_t  result;  //< STRSEPF_RESULT_OK or the error of this file
+    int      errnum;  //< errno of a STRSEPF_RESULT_ERR_IO error
+} strsepf_ingest_stats;
+
+//-------------------------------------------//
+//                                           //
+//               Interface                   //
+//                                           //
+//-------------------------------------------//
+
+/*
+ * `strsepf_ingest` reads a list of files and calls `config->onRecord` for every
+ * line of every file.
+ *
+ * Up to `nInflight` files are read at the same time, one large read in flight
+ * each. With io_uring, all the reads are queued to the kernel at once and the
+ * records of a buffer are handed to `onRecord` while the other reads complete.
+ * The pread back end runs the same state machine with blocking reads.
+ *
+ * The records of a file are handed in order. The records of different files
+ * are interleaved.
+ *
+ * ARGUMENTS:
+ *  @param: config - Buffers, back end and record callback.
+ *  @param: paths  - Files to ingest.
+ *  @param: nFiles - Number of files.
+ *  @param: stats  - Per-file statistics (output, nFiles elements).
+ *
+ * RETURNS:
+ *  Will return the number of files ingested without error, or a negative number
+ *  if the configuration is invalid or the requested back end isn't available.
+ *  A file error (open/read failure, record longer than `bufferSize`) only stops
+ *  that file, see its `stats[i].result`.
+ */
+STRSEPF_API int32_t
+strsepf_ingest(strsepf_ingest_config const* config,
+               char const* const            paths[],
+               size_t                       nFiles,
+               strsepf_ingest_stats         stats[]);
+
+//-------------------------------------------//
+//                                           //
+//          Internal interface               //
+//                                           //
+//-------------------------------------------//
+
+/*
+ * Enter the io_uring instance (io_uring_enter system call).
+ *
+ * RETURNS:
+ *  The number of consumed submissions, or -1 with errno.
+ */
+typedef int (*strsepf_ingest_enter_fn_)(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags);
+
+// io_uring_enter of the io_uring back end. The tests replace it to force the
+// submission failures.
+STRSEPF_API extern strsepf_ingest_enter_fn_ strsepf_ingest_enter_;
+
+#ifdef __cplusplus
+}
+#endif
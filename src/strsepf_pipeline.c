@@ -0,0 +1,306 @@
+/* +------------------------------------------------------+
+ * | strsepf_pipeline.c                                   |
+ * | Lock-free single-producer/single-consumer rings of   |
+ * | record-aligned buffers, to overlap reading and       |
+ * | parsing on different threads.                        |
+ * |                                                      |
+ * +------------------------------------------------------+
+ * |                                        G. Berthiaume |
+ * |                                          MIT licence |
+ * |                                                 2019 |
+ * +------------------------------------------------------+
+ */
+#include "strsepf_pipeline.h"
+
+//-------------------------------------------//
+//                                           //
+//                Includes                   //
+//                                           //
+//-------------------------------------------//
+#include <errno.h>     //< cstdlib : EINTR, EAGAIN
+#include <stdalign.h>  //< cstdlib : alignof
+#include <stdatomic.h> //< cstdlib : atomic_size_t
+#include <stdint.h>    //< cstdlib : INT32_MAX
+#include <string.h>    //< cstdlib : memchr, memmove
+#include <unistd.h>    //< posix   : read
+
+//-------------------------------------------//
+//                                           //
+//          Internal definitions             //
+//                                           //
+//-------------------------------------------//
+
+// The ring indexes are declared as `size_t` in the header, and accessed as atomics.
+_Static_assert(sizeof(atomic_size_t) == sizeof(size_t) && alignof(atomic_size_t) == alignof(size_t),
+               "strsepf_ring: atomic_size_t doesn't have the layout of size_t");
+
+#define STRSEPF_ATOMIC(index) ((atomic_size_t*)(index))
+
+//-------------------------------------------//
+//                                           //
+//              Implementation               //
+//                                           //
+//-------------------------------------------//
+
+int16_t
+strsepf_ring_init(strsepf_ring*  ring,
+                  char           storage[],
+                  size_t         slotSize,
+                  strsepf_batch  batches[],
+                  size_t         nSlots)
+{
+    if (ring == NULL || storage == NULL || batches == NULL || slotSize < 2 || nSlots == 0 ||
+        (nSlots & (nSlots - 1)) != 0) {
+        return STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+    }
+
+    ring->storage = storage;
+    ring->slotSize = slotSize;
+    ring->mask = nSlots - 1;
+    ring->batches = batches;
+    atomic_init(STRSEPF_ATOMIC(&ring->head), 0);
+    atomic_init(STRSEPF_ATOMIC(&ring->tail), 0);
+    ring->tailCache = 0;
+    ring->headCache = 0;
+    return STRSEPF_RESULT_OK;
+}
+
+char*
+strsepf_ring_acquire(strsepf_ring* ring)
+{
+    size_t const head = atomic_load_explicit(STRSEPF_ATOMIC(&ring->head), memory_order_relaxed);
+    if (head - ring->tailCache > ring->mask) {
+        ring->tailCache = atomic_load_explicit(STRSEPF_ATOMIC(&ring->tail), memory_order_acquire);
+        if (head - ring->tailCache > ring->mask) {
+            return NULL; //< Full: backpressure
+        }
+    }
+    return &ring->storage[(head & ring->mask) * ring->slotSize];
+}
+
+void
+strsepf_ring_publish(strsepf_ring* ring, size_t len, uint64_t seq)
+{
+    size_t const   head = atomic_load_explicit(STRSEPF_ATOMIC(&ring->head), memory_order_relaxed);
+    strsepf_batch* batch = &ring->batches[head & ring->mask];
+
+    batch->data = &ring->storage[(head & ring->mask) * ring->slotSize];
+    batch->len = len;
+    batch->seq = seq;
+    atomic_store_explicit(STRSEPF_ATOMIC(&ring->head), head + 1, memory_order_release);
+}
+
+strsepf_batch*
+strsepf_ring_peek(strsepf_ring* ring)
+{
+    size_t const tail = atomic_load_explicit(STRSEPF_ATOMIC(&ring->tail), memory_order_relaxed);
+    if (tail == ring->headCache) {
+        ring->headCache = atomic_load_explicit(STRSEPF_ATOMIC(&ring->head), memory_order_acquire);
+        if (tail == ring->headCache) {
+            return NULL; //< Empty
+        }
+    }
+    return &ring->batches[tail & ring->mask];
+}
+
+void
+strsepf_ring_release(strsepf_ring* ring)
+{
+    size_t const tail = atomic_load_explicit(STRSEPF_ATOMIC(&ring->tail), memory_order_relaxed);
+    atomic_store_explicit(STRSEPF_ATOMIC(&ring->tail), tail + 1, memory_order_release);
+}
+
+int16_t
+strsepf_reader_init(strsepf_reader* reader, int fd, char carry[], size_t slotSize)
+{
+    if (reader == NULL || fd < 0 || carry == NULL || slotSize < 2 || slotSize > INT32_MAX) {
+        return STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+    }
+
+    reader->fd = fd;
+    reader->carry = carry;
+    reader->carryLen = 0;
+    reader->slotSize = slotSize;
+    reader->next = 0;
+    reader->seq = 0;
+    reader->eof = false;
+    return STRSEPF_RESULT_OK;
+}
+
+int32_t
+strsepf_reader_step(strsepf_reader* reader, strsepf_ring rings[], size_t nRings)
+{
+    if (reader == NULL || rings == NULL || nRings == 0) {
+        return STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+    }
+    for (size_t i = 0; i < nRings; i++) {
+        if (rings[i].slotSize != reader->slotSize) {
+            return STRSEPF_RESULT_ERR_INVALID_PARAMETER; //< The carry wouldn't fit
+        }
+    }
+    if (reader->eof) {
+        return 0;
+    }
+
+    // Backpressure: only read when a worker has a free buffer
+    size_t        index = 0;
+    strsepf_ring* ring = NULL;
+    char*         slot = NULL;
+    for (size_t i = 0; i < nRings && slot == NULL; i++) {
+        index = (reader->next + i) % nRings;
+        ring = &rings[index];
+        slot = strsepf_ring_acquire(ring);
+    }
+    if (slot == NULL) {
+        return 0;
+    }
+
+    // Start with the incomplete record of the last read
+    size_t const capacity = ring->slotSize - 1; //< Keep room for the final '\0'
+    size_t       len = reader->carryLen;
+    memcpy(slot, reader->carry, len);
+
+    ssize_t n;
+    do {
+        n = read(reader->fd, &slot[len], capacity - len);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return 0;
+        }
+        return STRSEPF_RESULT_ERR_IO;
+    }
+    len += (size_t)n;
+
+    // End of input: publish what's left
+    if (n == 0) {
+        reader->eof = true;
+        reader->carryLen = 0;
+        if (len == 0) {
+            return 0;
+        }
+        slot[len] = '\0';
+        strsepf_ring_publish(ring, len, reader->seq++);
+        reader->next = (index + 1) % nRings;
+        return (int32_t)len;
+    }
+
+    // Keep the incomplete record for the next batch
+    size_t end = len;
+    while (end > 0 && slot[end - 1] != '\n') {
+        end--;
+    }
+    if (end == 0) {
+        if (len == capacity) {
+            return STRSEPF_RESULT_ERR_RECORD_TOO_LONG;
+        }
+        memcpy(reader->carry, slot, len);
+        reader->carryLen = len;
+        return 0; //< No complete record yet
+    }
+    memcpy(reader->carry, &slot[end], len - end);
+    reader->carryLen = len - end;
+
+    slot[end] = '\0';
+    strsepf_ring_publish(ring, end, reader->seq++);
+    reader->next = (index + 1) % nRings;
+    return (int32_t)end;
+}
+
+char*
+strsepf_batch_next(strsepf_batch* batch, char** cursor)
+{
+    if (batch == NULL || cursor == NULL || *cursor == NULL) {
+        return NULL;
+    }
+    if (*cursor >= &batch->data[batch->len]) {
+        *cursor = NULL;
+        return NULL;
+    }
+
+    char* record = *cursor;
+    char* end = memchr(record, '\n', (size_t)(&batch->data[batch->len] - record));
+    if (end == NULL) {
+        *cursor = &batch->data[batch->len]; //< Last record without a delimiter
+    } else {
+        *end = '\0';
+        *cursor = end + 1;
+    }
+    return record;
+}
+
+int16_t
+strsepf_worker_init(strsepf_worker*  worker,
+                    strsepf_ring*    in,
+                    strsepf_ring*    out,
+                    size_t           recordSize,
+                    strsepf_parse_fn parse,
+                    void const*      ctx)
+{
+    if (worker == NULL || in == NULL || out == NULL || parse == NULL || recordSize == 0 ||
+        recordSize > out->slotSize) {
+        return STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+    }
+
+    worker->in = in;
+    worker->out = out;
+    worker->recordSize = recordSize;
+    worker->parse = parse;
+    worker->ctx = ctx;
+    worker->batch = NULL;
+    worker->cursor = NULL;
+    worker->slot = NULL;
+    worker->used = 0;
+    worker->dropped = 0;
+    return STRSEPF_RESULT_OK;
+}
+
+int32_t
+strsepf_worker_step(strsepf_worker* worker)
+{
+    if (worker == NULL) {
+        return STRSEPF_RESULT_ERR_INVALID_PARAMETER;
+    }
+    if (worker->batch == NULL) {
+        worker->batch = strsepf_ring_peek(worker->in);
+        if (worker->batch == NULL) {
+            return 0; //< Nothing to parse
+        }
+        worker->cursor = worker->batch->data;
+    }
+
+    int32_t n = 0;
+    for (;;) {
+        if (worker->slot == NULL) {
+            worker->slot = strsepf_ring_acquire(worker->out);
+            if (worker->slot == NULL) {
+                return n; //< Backpressure: resume at the same record
+            }
+            worker->used = 0;
+        }
+
+        strsepf_batch* const batch = worker->batch;
+        bool const           ended = (worker->cursor >= &batch->data[batch->len]);
+        bool const           full = (worker->out->slotSize - worker->used < worker->recordSize);
+        if (!ended && !full) {
+            char* record = strsepf_batch_next(batch, &worker->cursor);
+            if (worker->parse(record, &worker->slot[worker->used], worker->ctx) < STRSEPF_RESULT_OK) {
+                worker->dropped++;
+            } else {
+                worker->used += worker->recordSize;
+                n++;
+            }
+            continue;
+        }
+
+        // Publish the parsed records with the sequence number of their input batch
+        strsepf_ring_publish(worker->out, worker->used, batch->seq);
+        worker->slot = NULL;
+        if (ended) {
+            strsepf_ring_release(worker->in);
+            worker->batch = NULL;
+            return n;
+        }
+    }
+}
@@ -0,0 +1,285 @@
+/* +------------------------------------------------------+
+ * | strsepf_pipeline.h                                   |
+ * | Lock-free single-producer/single-consumer rings of   |
+ * | record-aligned buffers, to overlap reading and       |
+ * | parsing on different threads.                        |
+ * |                                                      |
+ * +------------------------------------------------------+
+ * |                                        G. Berthiaume |
+ * |                                          MIT licence |
+ * |                                                 2019 |
+ * +------------------------------------------------------+
+ */
+#pragma once
+
+//-------------------------------------------//
+//                                           //
+//                Includes                   //
+//                                           //
+//-------------------------------------------//
+#include <stdbool.h> //< cstdlib : bool
+#include <stddef.h>  //< cstdlib : size_t
+#include <stdint.h>  //< cstdlib : uint64_t
+
+#include "strsepf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//-------------------------------------------//
+//                                           //
+//             Definitions                   //
+//                                           //
+//-------------------------------------------//
+
+// Size of a cache line, used to keep the producer and consumer indexes apart.
+#ifndef STRSEPF_CACHE_LINE
+#define STRSEPF_CACHE_LINE 64
+#endif
+
+#ifdef __cplusplus
+#define STRSEPF_ALIGNAS(n) alignas(n)
+#else
+#define STRSEPF_ALIGNAS(n) _Alignas(n)
+#endif
+
+/*
+ * A batch of complete records, separated by '\n' and terminated by '\0'.
+ */
+typedef struct
+{
+    char*    data; //< Mutable records
+    size_t   len;  //< Number of bytes, without the final '\0'
+    uint64_t seq;  //< Batch sequence number, to restore the input order across rings
+} strsepf_batch;
+
+/*
+ * A lock-free single-producer/single-consumer ring of fixed-size buffers.
+ * All the memory is provided by the caller.
+ *
+ * - The number of slots is the backpressure: the producer can't get ahead of the
+ *   consumer by more than `nSlots` batches.
+ * - The slot size is the batch size: the largest number of bytes handed to the
+ *   consumer at once (and the largest record).
+ *
+ * The indexes are atomics, only accessed through the `strsepf_ring_*` functions:
+ * they are declared as `size_t` so that the header is also valid C++.
+ */
+typedef struct
+{
+    // Shared, read-only after `strsepf_ring_init`
+    char*          storage;
+    size_t         slotSize;
+    size_t         mask;
+    strsepf_batch* batches;
+
+    // Producer side
+    STRSEPF_ALIGNAS(STRSEPF_CACHE_LINE) size_t head; //< Atomic
+    size_t tailCache;
+
+    // Consumer side
+    STRSEPF_ALIGNAS(STRSEPF_CACHE_LINE) size_t tail; //< Atomic
+    size_t headCache;
+} strsepf_ring;
+
+/*
+ * A reader stage: fills rings with record-aligned batches read from a file descriptor.
+ * Records are lines, terminated by '\n'.
+ */
+typedef struct
+{
+    int      fd;
+    char*    carry;    //< Incomplete record of the last read (caller storage, slotSize bytes)
+    size_t   carryLen;
+    size_t   slotSize; //< Slot size of every ring
+    size_t   next;     //< Next ring to fill
+    uint64_t seq;      //< Next batch sequence number
+    bool     eof;      //< The last batch has been published
+} strsepf_reader;
+
+/*
+ * Parse one record into `parsed`, a caller record of `recordSize` bytes, with a
+ * format shared by all the workers (`ctx`, read-only).
+ * A negative return value drops the record (parse error or rejected by a predicate).
+ *
+ * NOTE:
+ * The record is released with its batch: copy the %s tokens into `parsed`.
+ */
+typedef int16_t (*strsepf_parse_fn)(char* record, void* parsed, void const* ctx);
+
+/*
+ * A parser worker stage: parses the batches of an input ring and publishes the
+ * parsed records to an output ring.
+ *
+ * An output batch is an array of `recordSize` bytes records, with the `seq` of
+ * its input batch. An input batch gives one or more output batches (when it
+ * doesn't fit in an output buffer), published in order, possibly empty.
+ */
+typedef struct
+{
+    strsepf_ring*    in;         //< Batches of records, from the reader stage
+    strsepf_ring*    out;        //< Batches of parsed records
+    size_t           recordSize; //< Size of a parsed record
+    strsepf_parse_fn parse;
+    void const*      ctx;        //< Shared format, given to `parse`
+    strsepf_batch*   batch;      //< Input batch being parsed, NULL if none
+    char*            cursor;     //< Next record of `batch`
+    char*            slot;       //< Output buffer being filled, NULL if none
+    size_t           used;       //< Bytes used in `slot`
+    uint64_t         dropped;    //< Records for which `parse` failed
+} strsepf_worker;
+
+//-------------------------------------------//
+//                                           //
+//               Interface                   //
+//                                           //
+//-------------------------------------------//
+
+/*
+ * Initialize a ring.
+ *
+ * ARGUMENTS:
+ *  @param: ring     - Ring to initialize.
+ *  @param: storage  - Buffers, nSlots * slotSize bytes.
+ *  @param: slotSize - Size of a buffer, including the final '\0' of a batch.
+ *  @param: batches  - Batch descriptors, nSlots elements.
+ *  @param: nSlots   - Number of buffers. Shall be a power of 2.
+ *
+ * RETURNS:
+ *  STRSEPF_RESULT_OK or a negative number if the parameters are invalid.
+ */
+STRSEPF_API int16_t
+strsepf_ring_init(strsepf_ring*  ring,
+                  char           storage[],
+                  size_t         slotSize,
+                  strsepf_batch  batches[],
+                  size_t         nSlots);
+
+/*
+ * Producer: get the next free buffer (slotSize bytes), or NULL if the ring is full.
+ * The buffer is handed to the consumer by `strsepf_ring_publish`.
+ */
+STRSEPF_API char*
+strsepf_ring_acquire(strsepf_ring* ring);
+
+/*
+ * Producer: publish the buffer returned by `strsepf_ring_acquire`.
+ */
+STRSEPF_API void
+strsepf_ring_publish(strsepf_ring* ring, size_t len, uint64_t seq);
+
+/*
+ * Consumer: get the oldest published batch, or NULL if the ring is empty.
+ * The batch stays valid until `strsepf_ring_release`.
+ */
+STRSEPF_API strsepf_batch*
+strsepf_ring_peek(strsepf_ring* ring);
+
+/*
+ * Consumer: give the batch returned by `strsepf_ring_peek` back to the producer.
+ */
+STRSEPF_API void
+strsepf_ring_release(strsepf_ring* ring);
+
+/*
+ * Initialize a reader stage.
+ *
+ * ARGUMENTS:
+ *  @param: reader   - Reader to initialize.
+ *  @param: fd       - File descriptor to read (file, pipe or socket).
+ *  @param: carry    - Buffer of slotSize bytes, holding the incomplete record
+ *                     between two reads.
+ *  @param: slotSize - Slot size of the rings to fill, at most INT32_MAX.
+ *
+ * RETURNS:
+ *  STRSEPF_RESULT_OK or a negative number if the parameters are invalid.
+ */
+STRSEPF_API int16_t
+strsepf_reader_init(strsepf_reader* reader, int fd, char carry[], size_t slotSize);
+
+/*
+ * `strsepf_reader_step` runs one step of the reader stage: it reads once from the
+ * file descriptor and publishes the complete records to the next ring with a
+ * free buffer (round-robin, one ring per parser worker).
+ *
+ * Every published batch only holds complete records: the incomplete record at
+ * the end of a read is carried over to the next batch. At the end of the input,
+ * the last record is published even without a delimiter and `reader->eof` is set.
+ *
+ * ARGUMENTS:
+ *  @param: reader - Reader stage.
+ *  @param: rings  - Rings of the parser workers.
+ *  @param: nRings - Number of rings.
+ *
+ * The next step starts with the ring following the one that was published to.
+ *
+ * RETURNS:
+ *  The number of bytes published, 0 if all the rings are full (backpressure),
+ *  the read would block or no record is complete yet, or a negative number on error:
+ *  - STRSEPF_RESULT_ERR_INVALID_PARAMETER if a ring slot size isn't the reader's.
+ *  - STRSEPF_RESULT_ERR_RECORD_TOO_LONG if a record doesn't fit in a buffer.
+ *  - STRSEPF_RESULT_ERR_IO if the read failed (see errno).
+ *
+ * USAGE EXAMPLE:
+ *
+ *    // Reader thread                        // Worker thread i
+ *    while (!reader.eof) {                   for (;;) {
+ *        int32_t rc = strsepf_reader_step(       if (strsepf_worker_step(&workers[i]) == 0) {
+ *            &reader, rings, nWorkers);              //< Nothing to parse or output full: wait
+ *        if (rc < 0) {                           }
+ *            break;                          }
+ *        }
+ *    }                                       // Consumer: merge the output rings by `seq`
+ */
+STRSEPF_API int32_t
+strsepf_reader_step(strsepf_reader* reader, strsepf_ring rings[], size_t nRings);
+
+/*
+ * Get the next record of a batch, or NULL at the end of the batch.
+ * The record delimiter is replaced by '\0', so the record can be given to `strsepf`.
+ * `cursor` shall be initialized to `batch->data`.
+ */
+STRSEPF_API char*
+strsepf_batch_next(strsepf_batch* batch, char** cursor);
+
+/*
+ * Initialize a parser worker stage.
+ *
+ * ARGUMENTS:
+ *  @param: worker     - Worker to initialize.
+ *  @param: in         - Input ring, filled by the reader stage.
+ *  @param: out        - Output ring. Its buffers shall be aligned for the parsed
+ *                       record type and hold at least one record.
+ *  @param: recordSize - Size of a parsed record.
+ *  @param: parse      - Parses a record.
+ *  @param: ctx        - Shared format given to `parse` (eg a format string or a
+ *                       compiled `strsepf_kv`).
+ *
+ * RETURNS:
+ *  STRSEPF_RESULT_OK or a negative number if the parameters are invalid.
+ */
+STRSEPF_API int16_t
+strsepf_worker_init(strsepf_worker*  worker,
+                    strsepf_ring*    in,
+                    strsepf_ring*    out,
+                    size_t           recordSize,
+                    strsepf_parse_fn parse,
+                    void const*      ctx);
+
+/*
+ * `strsepf_worker_step` runs one step of a parser worker: it parses the records
+ * of the oldest input batch into the output ring, then releases the input batch.
+ * When the output ring is full, the step stops and the next one resumes at the
+ * same record.
+ *
+ * RETURNS:
+ *  The number of records published, 0 if there is no input batch or the output
+ *  ring is full (backpressure), or a negative number if the parameters are invalid.
+ */
+STRSEPF_API int32_t
+strsepf_worker_step(strsepf_worker* worker);
+
+#ifdef __cplusplus
+}
+#endif
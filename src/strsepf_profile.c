@@ -0,0 +1,374 @@
+/* +------------------------------------------------------+
+ * | strsepf_profile.c                                    |
+ * | Per-stage profiling of the parser: hardware counters |
+ * | (perf_event_open on Linux) or time stamp counter,    |
+ * | accumulated for every internal stage of `strsepf`.   |
+ * |                                                      |
+ * +------------------------------------------------------+
+ * |                                        G. Berthiaume |
+ * |                                          MIT licence |
+ * |                                                 2019 |
+ * +------------------------------------------------------+
+ */
+
+// NOTE:
+// This file uses POSIX 2008 functions (clock_gettime, mmap) and, on Linux, the
+// perf_event_open system call.
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include "strsepf_profile.h"
+
+//-------------------------------------------//
+//                                           //
+//                Includes                   //
+//                                           //
+//-------------------------------------------//
+#include <stdbool.h> //< cstdlib : bool
+#include <stdint.h>  //< cstdlib : *int*_t
+#include <string.h>  //< cstdlib : memset, memcpy
+#include <time.h>    //< posix   : clock_gettime
+#include <unistd.h>  //< posix   : read, close, sysconf
+
+#if defined(__linux__) && !defined(STRSEPF_NO_PERF) && defined(__has_include)
+#if __has_include(<linux/perf_event.h>)
+#define STRSEPF_HAS_PERF 1
+#include <linux/perf_event.h> //< linux : perf_event_attr, perf_event_mmap_page
+#include <sys/ioctl.h>        //< linux : ioctl
+#include <sys/mman.h>         //< posix : mmap
+#include <sys/syscall.h>      //< linux : __NR_perf_event_open
+#endif
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define STRSEPF_PROFILE_X86 1
+#endif
+
+//-------------------------------------------//
+//                                           //
+//          Internal definitions             //
+//                                           //
+//-------------------------------------------//
+
+// Number of back to back reads used to measure the cost of a read.
+#define STRSEPF_PROFILE_CALIBRATION 256
+
+/*
+ * Profiler state. There is a single profile per process.
+ */
+typedef struct
+{
+    strsepf_profile profile;
+    strsepf_stage   stage;                                 //< Current stage, COUNT if idle
+    uint64_t        last[STRSEPF_COUNTER_COUNT];           //< Counters at the last stage change
+    uint64_t        overhead[STRSEPF_COUNTER_COUNT];       //< Cost of a read
+#ifdef STRSEPF_HAS_PERF
+    int                                 fds[STRSEPF_COUNTER_COUNT]; //< -1 if not available
+    struct perf_event_mmap_page volatile* pages[STRSEPF_COUNTER_COUNT];
+    size_t                              pageSize;
+#endif
+} strsepf_profiler_;
+
+static strsepf_profiler_ profiler_ = {
+    .profile = { .source = STRSEPF_PROFILE_OFF },
+    .stage = STRSEPF_STAGE_COUNT,
+#ifdef STRSEPF_HAS_PERF
+    .fds = { -1, -1, -1 },
+#endif
+};
+
+//-------------------------------------------//
+//                                           //
+//        Internal function definitions      //
+//                                           //
+//-------------------------------------------//
+
+static uint64_t
+strsepf_clock_read_(void)
+{
+#ifdef STRSEPF_PROFILE_X86
+    if (profiler_.profile.source == STRSEPF_PROFILE_TSC) {
+        return __builtin_ia32_rdtsc();
+    }
+#endif
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+#ifdef STRSEPF_HAS_PERF
+/*
+ * Read the counters of the group with a single system call.
+ */
+static void
+strsepf_perf_read_(uint64_t now[])
+{
+    // PERF_FORMAT_GROUP layout: number of events, then a value per event, in
+    // the order they were added to the group.
+    uint64_t values[1 + STRSEPF_COUNTER_COUNT] = { 0 };
+    if (read(profiler_.fds[STRSEPF_COUNTER_CYCLES], values, sizeof(values)) <= 0) {
+        return;
+    }
+    size_t next = 1;
+    for (size_t c = 0; c < STRSEPF_COUNTER_COUNT; c++) {
+        if (profiler_.fds[c] >= 0 && next <= values[0]) {
+            now[c] = values[next++];
+        }
+    }
+}
+
+#ifdef STRSEPF_PROFILE_X86
+/*
+ * Read a counter from user space with rdpmc.
+ * See the perf_event_mmap_page documentation in <linux/perf_event.h>.
+ *
+ * RETURNS:
+ *  false if the event isn't scheduled on the PMU (the count must then be read
+ *  with a system call).
+ */
+static bool
+strsepf_perf_rdpmc_(struct perf_event_mmap_page volatile* page, uint64_t* value)
+{
+    uint32_t seq;
+    bool     scheduled;
+    do {
+        seq = page->lock;
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+
+        uint32_t const index = page->index;
+        int64_t        count = page->offset;
+        scheduled = (index != 0);
+        if (scheduled) {
+            uint16_t const width = page->pmc_width;
+            int64_t        pmc = (int64_t)__builtin_ia32_rdpmc((int)index - 1);
+            pmc = (int64_t)((uint64_t)pmc << (64 - width)) >> (64 - width); //< Sign extend
+            count += pmc;
+        }
+        *value = (uint64_t)count;
+
+        __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    } while (page->lock != seq);
+    return scheduled;
+}
+#endif
+#endif
+
+/*
+ * Read all the counters of the current source.
+ */
+static void
+strsepf_profile_now_(uint64_t now[])
+{
+    switch (profiler_.profile.source) {
+        case STRSEPF_PROFILE_PERF_RDPMC:
+#if defined(STRSEPF_HAS_PERF) && defined(STRSEPF_PROFILE_X86)
+            for (size_t c = 0; c < STRSEPF_COUNTER_COUNT; c++) {
+                if (profiler_.pages[c] != NULL && !strsepf_perf_rdpmc_(profiler_.pages[c], &now[c])) {
+                    strsepf_perf_read_(now); //< Not scheduled on the PMU
+                    return;
+                }
+            }
+            return;
+#endif
+        case STRSEPF_PROFILE_PERF_READ:
+#ifdef STRSEPF_HAS_PERF
+            strsepf_perf_read_(now);
+#endif
+            return;
+        case STRSEPF_PROFILE_TSC:
+        case STRSEPF_PROFILE_CLOCK:
+            now[STRSEPF_COUNTER_CYCLES] = strsepf_clock_read_();
+            return;
+        case STRSEPF_PROFILE_OFF:
+        default:
+            return;
+    }
+}
+
+#ifdef STRSEPF_HAS_PERF
+static int
+strsepf_perf_open_(uint64_t config, int groupFd)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = (groupFd == -1); //< The group is enabled by its leader
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(__NR_perf_event_open, &attr, 0 /* this thread */, -1 /* any cpu */, groupFd, 0);
+}
+
+static void
+strsepf_perf_close_(void)
+{
+    for (size_t c = 0; c < STRSEPF_COUNTER_COUNT; c++) {
+        if (profiler_.pages[c] != NULL) {
+            munmap((void*)profiler_.pages[c], profiler_.pageSize);
+            profiler_.pages[c] = NULL;
+        }
+        if (profiler_.fds[c] >= 0) {
+            close(profiler_.fds[c]);
+            profiler_.fds[c] = -1;
+        }
+    }
+}
+
+/*
+ * Open the hardware counters as a single group, cycles being the leader.
+ *
+ * RETURNS:
+ *  The source of the counters, STRSEPF_PROFILE_OFF if perf isn't available.
+ */
+static strsepf_profile_source
+strsepf_perf_start_(void)
+{
+    static uint64_t const configs[STRSEPF_COUNTER_COUNT] = {
+        [STRSEPF_COUNTER_CYCLES] = PERF_COUNT_HW_CPU_CYCLES,
+        [STRSEPF_COUNTER_BRANCH_MISSES] = PERF_COUNT_HW_BRANCH_MISSES,
+        [STRSEPF_COUNTER_CACHE_MISSES] = PERF_COUNT_HW_CACHE_MISSES,
+    };
+
+    profiler_.fds[STRSEPF_COUNTER_CYCLES] = strsepf_perf_open_(configs[STRSEPF_COUNTER_CYCLES], -1);
+    if (profiler_.fds[STRSEPF_COUNTER_CYCLES] < 0) {
+        return STRSEPF_PROFILE_OFF;
+    }
+    for (size_t c = 0; c < STRSEPF_COUNTER_COUNT; c++) {
+        if (c != STRSEPF_COUNTER_CYCLES) {
+            // Optional: some virtual PMUs don't count every event
+            profiler_.fds[c] = strsepf_perf_open_(configs[c], profiler_.fds[STRSEPF_COUNTER_CYCLES]);
+        }
+    }
+
+    int const leader = profiler_.fds[STRSEPF_COUNTER_CYCLES];
+    if (ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP) < 0 ||
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP) < 0) {
+        strsepf_perf_close_();
+        return STRSEPF_PROFILE_OFF;
+    }
+
+#ifdef STRSEPF_PROFILE_X86
+    // User space reads need a mapped page per event, with rdpmc allowed
+    profiler_.pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    bool rdpmc = true;
+    for (size_t c = 0; c < STRSEPF_COUNTER_COUNT; c++) {
+        if (profiler_.fds[c] < 0) {
+            continue;
+        }
+        void* page = mmap(NULL, profiler_.pageSize, PROT_READ, MAP_SHARED, profiler_.fds[c], 0);
+        if (page == MAP_FAILED) {
+            rdpmc = false;
+            break;
+        }
+        profiler_.pages[c] = page;
+        rdpmc = rdpmc && profiler_.pages[c]->cap_user_rdpmc;
+    }
+    if (rdpmc) {
+        return STRSEPF_PROFILE_PERF_RDPMC;
+    }
+    for (size_t c = 0; c < STRSEPF_COUNTER_COUNT; c++) {
+        if (profiler_.pages[c] != NULL) {
+            munmap((void*)profiler_.pages[c], profiler_.pageSize);
+            profiler_.pages[c] = NULL;
+        }
+    }
+#endif
+    return STRSEPF_PROFILE_PERF_READ;
+}
+#endif
+
+/*
+ * Measure the cost of a read: the smallest difference between two back to back
+ * reads, for every counter.
+ */
+static void
+strsepf_profile_calibrate_(void)
+{
+    for (size_t c = 0; c < STRSEPF_COUNTER_COUNT; c++) {
+        profiler_.overhead[c] = UINT64_MAX;
+    }
+    uint64_t prev[STRSEPF_COUNTER_COUNT] = { 0 };
+    strsepf_profile_now_(prev);
+    for (size_t i = 0; i < STRSEPF_PROFILE_CALIBRATION; i++) {
+        uint64_t now[STRSEPF_COUNTER_COUNT] = { 0 };
+        strsepf_profile_now_(now);
+        for (size_t c = 0; c < STRSEPF_COUNTER_COUNT; c++) {
+            uint64_t const delta = now[c] - prev[c];
+            if (delta < profiler_.overhead[c]) {
+                profiler_.overhead[c] = delta;
+            }
+        }
+        memcpy(prev, now, sizeof(prev));
+    }
+}
+
+//-------------------------------------------//
+//                                           //
+//       Public functions definitions        //
+//                                           //
+//-------------------------------------------//
+
+strsepf_profile_source
+strsepf_profile_start(void)
+{
+    strsepf_profile_stop();
+    memset(&profiler_.profile, 0, sizeof(profiler_.profile));
+
+    strsepf_profile_source source = STRSEPF_PROFILE_OFF;
+#ifdef STRSEPF_HAS_PERF
+    source = strsepf_perf_start_();
+#endif
+    if (source == STRSEPF_PROFILE_OFF) {
+#ifdef STRSEPF_PROFILE_X86
+        source = STRSEPF_PROFILE_TSC;
+#else
+        source = STRSEPF_PROFILE_CLOCK;
+#endif
+    }
+    profiler_.profile.source = source;
+    profiler_.stage = STRSEPF_STAGE_COUNT;
+    strsepf_profile_calibrate_();
+    return source;
+}
+
+void
+strsepf_profile_read(strsepf_profile* profile)
+{
+    *profile = profiler_.profile;
+}
+
+void
+strsepf_profile_stop(void)
+{
+#ifdef STRSEPF_HAS_PERF
+    strsepf_perf_close_();
+#endif
+    profiler_.profile.source = STRSEPF_PROFILE_OFF;
+    profiler_.stage = STRSEPF_STAGE_COUNT;
+}
+
+void
+strsepf_profile_mark_(strsepf_stage next)
+{
+    if (profiler_.profile.source == STRSEPF_PROFILE_OFF) {
+        return;
+    }
+
+    uint64_t now[STRSEPF_COUNTER_COUNT] = { 0 };
+    strsepf_profile_now_(now);
+    if (profiler_.stage != STRSEPF_STAGE_COUNT) {
+        strsepf_stage_profile* const stage = &profiler_.profile.stages[profiler_.stage];
+        for (size_t c = 0; c < STRSEPF_COUNTER_COUNT; c++) {
+            uint64_t const delta = now[c] - profiler_.last[c];
+            stage->counters[c] += (delta > profiler_.overhead[c]) ? delta - profiler_.overhead[c] : 0;
+        }
+    }
+    if (next != STRSEPF_STAGE_COUNT) {
+        profiler_.profile.stages[next].calls++;
+    }
+    memcpy(profiler_.last, now, sizeof(now));
+    profiler_.stage = next;
+}
@@ -0,0 +1,145 @@
+/* +------------------------------------------------------+
+ * | strsepf_profile.h                                    |
+ * | Per-stage profiling of the parser: hardware counters |
+ * | (perf_event_open on Linux) or time stamp counter,    |
+ * | accumulated for every internal stage of `strsepf`.   |
+ * |                                                      |
+ * +------------------------------------------------------+
+ * |                                        G. Berthiaume |
+ * |                                          MIT licence |
+ * |                                                 2019 |
+ * +------------------------------------------------------+
+ */
+#pragma once
+
+// NOTE:
+// This interface is only built with STRSEPF_PROFILE (cmake -DSTRSEPF_PROFILE=ON).
+// Every stage change reads the counters: the cost of a read is measured and
+// subtracted, but a profiling build stays slower than a release build. Compare
+// the stages between themselves, not with the release timings.
+
+//-------------------------------------------//
+//                                           //
+//                Includes                   //
+//                                           //
+//-------------------------------------------//
+#include <stdint.h> //< cstdlib : *int*_t
+
+#include "strsepf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//-------------------------------------------//
+//                                           //
+//             Definitions                   //
+//                                           //
+//-------------------------------------------//
+
+/*
+ * Enumerates the internal stages of the parser.
+ */
+typedef enum
+{
+    STRSEPF_STAGE_FORMAT,  //< Specifier decoding
+    STRSEPF_STAGE_LITERAL, //< Literal characters matching
+    STRSEPF_STAGE_SCAN,    //< Delimiter scan (tokenization)
+    STRSEPF_STAGE_WIDTH,   //< Width and predicate checks
+    STRSEPF_STAGE_CONVERT, //< Number conversion, predicates and interning
+    STRSEPF_STAGE_STORE,   //< Output stores
+    STRSEPF_STAGE_COUNT,
+} strsepf_stage;
+
+/*
+ * Enumerates the measured events.
+ */
+typedef enum
+{
+    STRSEPF_COUNTER_CYCLES,        //< CPU cycles, or time stamp counter ticks
+    STRSEPF_COUNTER_BRANCH_MISSES, //< Mispredicted branches
+    STRSEPF_COUNTER_CACHE_MISSES,  //< Last level cache misses
+    STRSEPF_COUNTER_COUNT,
+} strsepf_counter;
+
+/*
+ * Enumerates the sources of the counters.
+ */
+typedef enum
+{
+    STRSEPF_PROFILE_OFF,        //< Not profiling
+    STRSEPF_PROFILE_PERF_RDPMC, //< perf_event_open, read from user space with rdpmc
+    STRSEPF_PROFILE_PERF_READ,  //< perf_event_open, read with a system call
+    STRSEPF_PROFILE_TSC,        //< Time stamp counter (cycles only)
+    STRSEPF_PROFILE_CLOCK,      //< Monotonic clock in nanoseconds (cycles only)
+} strsepf_profile_source;
+
+/*
+ * Counters accumulated for a stage.
+ */
+typedef struct
+{
+    uint64_t calls;                           //< Number of times the stage was entered
+    uint64_t counters[STRSEPF_COUNTER_COUNT]; //< Events counted in the stage
+} strsepf_stage_profile;
+
+/*
+ * Profile of all the stages.
+ */
+typedef struct
+{
+    strsepf_profile_source source;
+    strsepf_stage_profile  stages[STRSEPF_STAGE_COUNT];
+} strsepf_profile;
+
+//-------------------------------------------//
+//                                           //
+//               Interface                   //
+//                                           //
+//-------------------------------------------//
+
+/*
+ * `strsepf_profile_start` clears the profile and starts counting the stages
+ * of the parser.
+ *
+ * The hardware counters are opened with perf_event_open (user space events of
+ * the calling thread). When they aren't available (no perf support, or denied
+ * by `perf_event_paranoid`), only the cycles are measured with the time stamp
+ * counter, or the monotonic clock on other architectures.
+ *
+ * The profile is global: only parse from the thread that started it.
+ *
+ * RETURNS:
+ *  The source of the counters.
+ */
+STRSEPF_API strsepf_profile_source
+strsepf_profile_start(void);
+
+/*
+ * Copy the counters accumulated since `strsepf_profile_start`.
+ */
+STRSEPF_API void
+strsepf_profile_read(strsepf_profile* profile);
+
+/*
+ * Stop counting and release the hardware counters.
+ */
+STRSEPF_API void
+strsepf_profile_stop(void);
+
+//-------------------------------------------//
+//                                           //
+//          Internal interface               //
+//                                           //
+//-------------------------------------------//
+
+/*
+ * Enter the stage `next`: the events since the previous call are attributed to
+ * the previous stage. STRSEPF_STAGE_COUNT leaves the parser (not attributed).
+ */
+void
+strsepf_profile_mark_(strsepf_stage next);
+
+#ifdef __cplusplus
+}
+#endif
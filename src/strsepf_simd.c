@@ -0,0 +1,371 @@
+/* +------------------------------------------------------+
+ * | strsepf_simd.c                                       |
+ * | Internal tokenizing and number conversion kernels,   |
+ * | selected once at startup for the running CPU.        |
+ * |                                                      |
+ * +------------------------------------------------------+
+ * |                                        G. Berthiaume |
+ * |                                          MIT licence |
+ * |                                                 2019 |
+ * +------------------------------------------------------+
+ */
+#include "strsepf_simd.h"
+
+//-------------------------------------------//
+//                                           //
+//                Includes                   //
+//                                           //
+//-------------------------------------------//
+#include <stdatomic.h> //< cstdlib : atomic function pointers
+#include <stdbool.h>   //< cstdlib : bool
+#include <stddef.h>    //< cstdlib : size_t
+#include <string.h>    //< cstdlib : strlen
+
+#include "strsepf.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define STRSEPF_SIMD_X86 1
+#include <immintrin.h> //< SSE4.2, AVX2 and AVX-512 intrinsics
+#endif
+
+//-------------------------------------------//
+//                                           //
+//          Internal definitions             //
+//                                           //
+//-------------------------------------------//
+
+#ifdef STRSEPF_SIMD_X86
+// The vector kernels read whole aligned blocks, which may go past the end of a
+// string (but never past its page).
+#define STRSEPF_KERNEL(isa) __attribute__((target(isa), no_sanitize_address))
+#endif
+
+typedef char* (*strsepf_scan_fn_)(char* s, char const* set);
+typedef uint32_t (*strsepf_convert_fn_)(char lanes[][STRSEPF_SIMD_LANE_SIZE], uint32_t values[]);
+
+static char*
+strsepf_scan_scalar_(char* s, char const* set);
+
+static uint32_t
+strsepf_convert_scalar_(char lanes[][STRSEPF_SIMD_LANE_SIZE], uint32_t values[]);
+
+// Selected kernels. Scalar until `strsepf_simd_init_` runs at startup.
+static _Atomic(strsepf_scan_fn_)    scanKernel = strsepf_scan_scalar_;
+static _Atomic(strsepf_convert_fn_) convertKernel = strsepf_convert_scalar_;
+static _Atomic(int)                 simdLevel = STRSEPF_SIMD_SCALAR;
+
+//-------------------------------------------//
+//                                           //
+//              Implementation               //
+//                                           //
+//-------------------------------------------//
+
+char*
+strsepf_scan_(char* s, char const* set)
+{
+    return atomic_load_explicit(&scanKernel, memory_order_relaxed)(s, set);
+}
+
+char*
+strsepf_tokenize_(char** stringp, char const* delim)
+{
+    char* s = *stringp;
+    if (s == NULL) {
+        return NULL;
+    }
+
+    char* end = strsepf_scan_(s, delim);
+    if (*end == '\0') {
+        *stringp = NULL;
+    } else {
+        *end = '\0';
+        *stringp = end + 1;
+    }
+    return s;
+}
+
+uint32_t
+strsepf_convert_lanes_(char lanes[][STRSEPF_SIMD_LANE_SIZE], uint32_t values[])
+{
+    return atomic_load_explicit(&convertKernel, memory_order_relaxed)(lanes, values);
+}
+
+//-------------------------------------------//
+//                                           //
+//              Scalar kernels               //
+//                                           //
+//-------------------------------------------//
+
+static char*
+strsepf_scan_scalar_(char* s, char const* set)
+{
+    for (;; s++) {
+        if (*s == '\0') {
+            return s;
+        }
+        for (char const* c = set; *c != '\0'; c++) {
+            if (*c == *s) {
+                return s;
+            }
+        }
+    }
+}
+
+static uint32_t
+strsepf_convert_scalar_(char lanes[][STRSEPF_SIMD_LANE_SIZE], uint32_t values[])
+{
+    uint32_t valid = 0;
+    for (size_t i = 0; i < STRSEPF_SIMD_LANES; i++) {
+        uint32_t value = 0;
+        bool     isDigits = true;
+        for (size_t j = 0; j < STRSEPF_SIMD_LANE_SIZE; j++) {
+            unsigned const digit = (unsigned)(unsigned char)lanes[i][j] - '0';
+            isDigits = isDigits && digit <= 9;
+            value = value * 10 + digit;
+        }
+        values[i] = value;
+        valid |= (uint32_t)isDigits << i;
+    }
+    return valid;
+}
+
+#ifdef STRSEPF_SIMD_X86
+
+//-------------------------------------------//
+//                                           //
+//              SSE4.2 kernels               //
+//                                           //
+//-------------------------------------------//
+
+STRSEPF_KERNEL("sse4.2")
+static char*
+strsepf_scan_sse42_(char* s, char const* set)
+{
+    size_t const nSet = strlen(set);
+    if (nSet > 16) {
+        return strsepf_scan_scalar_(s, set);
+    }
+
+    char needles[16] = { 0 };
+    memcpy(needles, set, nSet);
+    __m128i const needle = _mm_loadu_si128((__m128i const*)(void const*)needles);
+    __m128i const zero = _mm_setzero_si128();
+
+    // Unaligned head, then aligned blocks only: they never cross a page
+    for (; ((uintptr_t)s & 15) != 0; s++) {
+        if (*s == '\0' || memchr(set, *s, nSet) != NULL) {
+            return s;
+        }
+    }
+    for (;; s += 16) {
+        __m128i const block = _mm_load_si128((__m128i const*)(void*)s);
+        int const     index = _mm_cmpistri(needle, block,
+                                       _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+        if (index < 16) {
+            return s + index;
+        }
+        unsigned const nul = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(block, zero));
+        if (nul != 0) {
+            return s + __builtin_ctz(nul);
+        }
+    }
+}
+
+STRSEPF_KERNEL("sse4.2")
+static uint32_t
+strsepf_convert_sse42_(char lanes[][STRSEPF_SIMD_LANE_SIZE], uint32_t values[])
+{
+    __m128i const zero = _mm_set1_epi8('0');
+    __m128i const nine = _mm_set1_epi8(9);
+    __m128i const mul10 = _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1);
+    __m128i const mul100 = _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1);
+    __m128i const mul10000 = _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1);
+    __m128i const mul1e8 = _mm_setr_epi32(100000000, 1, 0, 0);
+
+    uint32_t valid = 0;
+    for (size_t i = 0; i < STRSEPF_SIMD_LANES; i++) {
+        __m128i const digits =
+          _mm_sub_epi8(_mm_load_si128((__m128i const*)(void const*)lanes[i]), zero);
+        __m128i const isDigit = _mm_cmpeq_epi8(_mm_max_epu8(digits, nine), nine);
+        valid |= (uint32_t)(_mm_movemask_epi8(isDigit) == 0xFFFF) << i;
+
+        __m128i v = _mm_maddubs_epi16(digits, mul10); //< 2 digits
+        v = _mm_madd_epi16(v, mul100);                //< 4 digits
+        v = _mm_packus_epi32(v, v);                   //< 4 digits, 16 bits
+        v = _mm_madd_epi16(v, mul10000);              //< 8 digits
+        v = _mm_mullo_epi32(v, mul1e8);               //< high half * 1e8, low half
+        v = _mm_hadd_epi32(v, v);                     //< 16 digits
+        values[i] = (uint32_t)_mm_cvtsi128_si32(v);
+    }
+    return valid;
+}
+
+//-------------------------------------------//
+//                                           //
+//               AVX2 kernels                //
+//                                           //
+//-------------------------------------------//
+
+STRSEPF_KERNEL("avx2")
+static char*
+strsepf_scan_avx2_(char* s, char const* set)
+{
+    size_t const nSet = strlen(set);
+    if (nSet > 4) {
+        return strsepf_scan_sse42_(s, set);
+    }
+
+    // Unused needles repeat the terminating '\0'
+    __m256i const n0 = _mm256_set1_epi8(set[0]);
+    __m256i const n1 = _mm256_set1_epi8(nSet > 1 ? set[1] : '\0');
+    __m256i const n2 = _mm256_set1_epi8(nSet > 2 ? set[2] : '\0');
+    __m256i const n3 = _mm256_set1_epi8(nSet > 3 ? set[3] : '\0');
+    __m256i const zero = _mm256_setzero_si256();
+
+    // Aligned blocks only: they never cross a page. The bytes before `s` are masked.
+    char*    block = (char*)((uintptr_t)s & ~(uintptr_t)31);
+    unsigned skip = (unsigned)(s - block);
+    for (;; block += 32, skip = 0) {
+        __m256i const b = _mm256_load_si256((__m256i const*)(void*)block);
+        __m256i const hit = _mm256_or_si256(
+          _mm256_or_si256(_mm256_cmpeq_epi8(b, n0), _mm256_cmpeq_epi8(b, n1)),
+          _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(b, n2), _mm256_cmpeq_epi8(b, n3)),
+                          _mm256_cmpeq_epi8(b, zero)));
+        uint32_t const mask = (uint32_t)_mm256_movemask_epi8(hit) >> skip;
+        if (mask != 0) {
+            return block + skip + __builtin_ctz(mask);
+        }
+    }
+}
+
+STRSEPF_KERNEL("avx2")
+static uint32_t
+strsepf_convert_avx2_(char lanes[][STRSEPF_SIMD_LANE_SIZE], uint32_t values[])
+{
+    __m256i const zero = _mm256_set1_epi8('0');
+    __m256i const nine = _mm256_set1_epi8(9);
+    __m256i const mul10 = _mm256_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1,
+                                           10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1);
+    __m256i const mul100 = _mm256_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1, 100, 1, 100, 1, 100, 1,
+                                             100, 1);
+    __m256i const mul10000 = _mm256_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1, 10000, 1,
+                                               10000, 1, 10000, 1, 10000, 1);
+    __m256i const mul1e8 = _mm256_setr_epi32(100000000, 1, 0, 0, 100000000, 1, 0, 0);
+
+    // Two lanes per register
+    uint32_t valid = 0;
+    for (size_t i = 0; i < STRSEPF_SIMD_LANES; i += 2) {
+        __m256i const digits =
+          _mm256_sub_epi8(_mm256_load_si256((__m256i const*)(void const*)lanes[i]), zero);
+        __m256i const  isDigit = _mm256_cmpeq_epi8(_mm256_max_epu8(digits, nine), nine);
+        uint32_t const mask = (uint32_t)_mm256_movemask_epi8(isDigit);
+        valid |= (uint32_t)((mask & 0x0000FFFFu) == 0x0000FFFFu) << i;
+        valid |= (uint32_t)((mask & 0xFFFF0000u) == 0xFFFF0000u) << (i + 1);
+
+        __m256i v = _mm256_maddubs_epi16(digits, mul10); //< 2 digits
+        v = _mm256_madd_epi16(v, mul100);                //< 4 digits
+        v = _mm256_packus_epi32(v, v);                   //< 4 digits, 16 bits
+        v = _mm256_madd_epi16(v, mul10000);              //< 8 digits
+        v = _mm256_mullo_epi32(v, mul1e8);               //< high half * 1e8, low half
+        v = _mm256_hadd_epi32(v, v);                     //< 16 digits
+        values[i] = (uint32_t)_mm256_extract_epi32(v, 0);
+        values[i + 1] = (uint32_t)_mm256_extract_epi32(v, 4);
+    }
+    return valid;
+}
+
+//-------------------------------------------//
+//                                           //
+//              AVX-512 kernels              //
+//                                           //
+//-------------------------------------------//
+
+STRSEPF_KERNEL("avx512f,avx512bw")
+static char*
+strsepf_scan_avx512_(char* s, char const* set)
+{
+    size_t const nSet = strlen(set);
+    if (nSet > 4) {
+        return strsepf_scan_sse42_(s, set);
+    }
+
+    __m512i const n0 = _mm512_set1_epi8(set[0]);
+    __m512i const n1 = _mm512_set1_epi8(nSet > 1 ? set[1] : '\0');
+    __m512i const n2 = _mm512_set1_epi8(nSet > 2 ? set[2] : '\0');
+    __m512i const n3 = _mm512_set1_epi8(nSet > 3 ? set[3] : '\0');
+    __m512i const zero = _mm512_setzero_si512();
+
+    char*    block = (char*)((uintptr_t)s & ~(uintptr_t)63);
+    unsigned skip = (unsigned)(s - block);
+    for (;; block += 64, skip = 0) {
+        __m512i const b = _mm512_load_si512((void const*)block);
+        __mmask64 const hit = _mm512_cmpeq_epi8_mask(b, n0) | _mm512_cmpeq_epi8_mask(b, n1) |
+                              _mm512_cmpeq_epi8_mask(b, n2) | _mm512_cmpeq_epi8_mask(b, n3) |
+                              _mm512_cmpeq_epi8_mask(b, zero);
+        uint64_t const mask = (uint64_t)hit >> skip;
+        if (mask != 0) {
+            return block + skip + __builtin_ctzll(mask);
+        }
+    }
+}
+
+#endif // STRSEPF_SIMD_X86
+
+//-------------------------------------------//
+//                                           //
+//               Dispatch                    //
+//                                           //
+//-------------------------------------------//
+
+strsepf_simd
+strsepf_simd_limit(strsepf_simd max)
+{
+    strsepf_simd        level = STRSEPF_SIMD_SCALAR;
+    strsepf_scan_fn_    scan = strsepf_scan_scalar_;
+    strsepf_convert_fn_ convert = strsepf_convert_scalar_;
+
+#ifdef STRSEPF_SIMD_X86
+    __builtin_cpu_init();
+    if (max >= STRSEPF_SIMD_SSE42 && __builtin_cpu_supports("sse4.2")) {
+        level = STRSEPF_SIMD_SSE42;
+        scan = strsepf_scan_sse42_;
+        convert = strsepf_convert_sse42_;
+    }
+    if (max >= STRSEPF_SIMD_AVX2 && __builtin_cpu_supports("avx2")) {
+        level = STRSEPF_SIMD_AVX2;
+        scan = strsepf_scan_avx2_;
+        convert = strsepf_convert_avx2_;
+    }
+    if (max >= STRSEPF_SIMD_AVX512 && __builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512bw")) {
+        level = STRSEPF_SIMD_AVX512;
+        scan = strsepf_scan_avx512_;
+        // NOTE: The conversion kernel is already 2 lanes per AVX2 register, the
+        // AVX-512 version was not faster (no 512 bits horizontal add).
+    }
+#else
+    (void)max;
+#endif
+
+    atomic_store_explicit(&scanKernel, scan, memory_order_relaxed);
+    atomic_store_explicit(&convertKernel, convert, memory_order_relaxed);
+    atomic_store_explicit(&simdLevel, (int)level, memory_order_relaxed);
+    return level;
+}
+
+strsepf_simd
+strsepf_simd_level(void)
+{
+    return (strsepf_simd)atomic_load_explicit(&simdLevel, memory_order_relaxed);
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+/*
+ * Select the kernels once, at startup (library load).
+ */
+__attribute__((constructor)) static void
+strsepf_simd_init_(void)
+{
+    strsepf_simd_limit(STRSEPF_SIMD_AVX512);
+}
+#endif
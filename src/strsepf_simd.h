@@ -0,0 +1,61 @@
+/* +------------------------------------------------------+
+ * | strsepf_simd.h                                       |
+ * | Internal tokenizing and number conversion kernels,   |
+ * | selected once at startup for the running CPU.        |
+ * |                                                      |
+ * +------------------------------------------------------+
+ * |                                        G. Berthiaume |
+ * |                                          MIT licence |
+ * |                                                 2019 |
+ * +------------------------------------------------------+
+ */
+#pragma once
+
+// NOTE:
+// This header is internal to the library, it is not installed with `strsepf.h`.
+
+//-------------------------------------------//
+//                                           //
+//                Includes                   //
+//                                           //
+//-------------------------------------------//
+#include <stdint.h> //< cstdlib : *int*_t
+
+//-------------------------------------------//
+//                                           //
+//             Definitions                   //
+//                                           //
+//-------------------------------------------//
+
+// Number of lanes converted by `strsepf_convert_lanes_`.
+#define STRSEPF_SIMD_LANES 8
+
+// Size of a lane: a number right-aligned and padded with '0'.
+#define STRSEPF_SIMD_LANE_SIZE 16
+
+//-------------------------------------------//
+//                                           //
+//               Interface                   //
+//                                           //
+//-------------------------------------------//
+
+/*
+ * Tokenizing kernel: returns the first character of `s` found in `set`, or the
+ * terminating '\0' of `s`.
+ */
+char*
+strsepf_scan_(char* s, char const* set);
+
+/*
+ * `strsep` on top of the tokenizing kernel, with the same semantics.
+ */
+char*
+strsepf_tokenize_(char** stringp, char const* delim);
+
+/*
+ * Conversion kernel: converts STRSEPF_SIMD_LANES lanes of up to 9 decimal digits.
+ * `lanes` shall be aligned on 32 bytes.
+ * Returns a mask with the bit i set if the lane i only contains digits.
+ */
+uint32_t
+strsepf_convert_lanes_(char lanes[][STRSEPF_SIMD_LANE_SIZE], uint32_t values[]);
@@ -1,7 +1,13 @@
 // C standars library
-#include <stdbool.h> //< bool
-#include <stdint.h>  //< *int*_t
-#include <stdio.h>   //< print
+#include <errno.h>     //< ENOENT
+#include <pthread.h>   //< pthread_create
+#include <stdatomic.h> //< atomic_bool
+#include <stdbool.h>   //< bool
+#include <stdint.h>    //< *int*_t
+#include <stdio.h>     //< print
+#include <stdlib.h>    //< mkstemp
+#include <string.h>    //< strlen, memset
+#include <unistd.h>    //< pipe
 
 // Unit tests framework
 // See : http://www.throwtheswitch.org/unity
@@ -9,6 +15,12 @@
 
 // Library under test
 #include "strsepf.h"
+#include "strsepf_columns.h"
+#include "strsepf_ingest.h"
+#include "strsepf_pipeline.h"
+#ifdef STRSEPF_PROFILE
+#include "strsepf_profile.h"
+#endif
 
 //-----------------------------------------------------------
 //
@@ -224,6 +236,1429 @@ test_strsepf_subspecfier_star()
     TEST_ASSERT_EQUAL(2, n);
 }
 
+//-----------------------------------------------------------
+//
+// Predicate tests
+//
+//-----------------------------------------------------------
+void
+test_strsepf_predicate_string_equal()
+{
+    char              test[] = "$GPGGA,123519,4807.038,N";
+    char const* const format = "$%*?s,%d,%s,%s";
+
+    strsepf_predicate const isGGA = { .type = STRSEPF_PREDICATE_EQUAL, .str = "GPGGA" };
+
+    uint32_t answer0 = 0;
+    char*    answer1 = NULL;
+    char*    answer2 = NULL;
+    int16_t  n = strsepf(test, format, &isGGA, &answer0, &answer1, &answer2);
+
+    TEST_ASSERT_EQUAL(3, n);
+    TEST_ASSERT_EQUAL(123519, answer0);
+    TEST_ASSERT_EQUAL_STRING("4807.038", answer1);
+    TEST_ASSERT_EQUAL_STRING("N", answer2);
+}
+
+void
+test_strsepf_predicate_rejects_before_next_fields()
+{
+    char              test[] = "$GPBWC,081837,,,,,,T,,M,,N,*13";
+    char const* const format = "$%*?s,%d,%s";
+
+    strsepf_predicate const isGGA = { .type = STRSEPF_PREDICATE_EQUAL, .str = "GPGGA" };
+
+    uint32_t answer0 = 0;
+    char*    answer1 = NULL;
+    int16_t  n = strsepf(test, format, &isGGA, &answer0, &answer1);
+
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_PREDICATE_REJECTED, n);
+    TEST_ASSERT_EQUAL(0, answer0);
+    TEST_ASSERT_EQUAL_STRING("081837,,,,,,T,,M,,N,*13", &test[7]); //< never tokenized
+}
+
+void
+test_strsepf_predicate_number_range()
+{
+    char              test[] = "id=42 level=7";
+    char const* const format = "id=%?d level=%d";
+
+    strsepf_predicate const idRange = { .type = STRSEPF_PREDICATE_RANGE, .min = 40, .max = 49 };
+
+    int32_t answer0 = 0;
+    int32_t answer1 = 0;
+    int16_t n = strsepf(test, format, &idRange, &answer0, &answer1);
+
+    TEST_ASSERT_EQUAL(2, n);
+    TEST_ASSERT_EQUAL(42, answer0);
+    TEST_ASSERT_EQUAL(7, answer1);
+
+    char test2[] = "id=50 level=7";
+    n = strsepf(test2, format, &idRange, &answer0, &answer1);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_PREDICATE_REJECTED, n);
+}
+
+void
+test_strsepf_predicate_one_of()
+{
+    char              test[] = "dev7,0x1F";
+    char const* const format = "%?s,%?x";
+
+    char const* const       names[] = { "dev3", "dev7" };
+    int64_t const           codes[] = { 0x10, 0x1F };
+    strsepf_predicate const isDevice = { .type = STRSEPF_PREDICATE_ONE_OF, .strs = names, .len = 2 };
+    strsepf_predicate const isCode = { .type = STRSEPF_PREDICATE_ONE_OF, .nums = codes, .len = 2 };
+
+    char*    answer0 = NULL;
+    uint32_t answer1 = 0;
+    int16_t  n = strsepf(test, format, &isDevice, &answer0, &isCode, &answer1);
+
+    TEST_ASSERT_EQUAL(2, n);
+    TEST_ASSERT_EQUAL_STRING("dev7", answer0);
+    TEST_ASSERT_EQUAL(0x1F, answer1);
+}
+
+void
+test_strsepf_predicate_range_on_string()
+{
+    char              test[] = "pump,42";
+    char const* const format = "%?s,%d";
+
+    strsepf_predicate const range = { .type = STRSEPF_PREDICATE_RANGE, .min = 0, .max = 9 };
+
+    char*   answer0 = NULL;
+    int32_t answer1 = 0;
+    int16_t n = strsepf(test, format, &range, &answer0, &answer1);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_ARGS, n); //< Not a rejected record
+    TEST_ASSERT_NULL(answer0);
+}
+
+void
+test_strsepf_predicate_null_arg()
+{
+    char              test[] = "51,area";
+    char const* const format = "%?d,%s";
+
+    int32_t answer0 = 0;
+    int16_t n = strsepf(test, format, NULL, &answer0, NULL);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_ARGS, n);
+}
+
+//-----------------------------------------------------------
+//
+// Repeated group tests
+//
+//-----------------------------------------------------------
+void
+test_strsepf_group_gpgsv()
+{
+    char              test[] = "$GPGSV,3,3,10,29,09,301,24,30,12,040,44*74";
+    char const* const format = "$GPGSV,%*d,%*d,%d,%{%d,%d,%d,%d,}4*%x";
+
+    int32_t  total = 0;
+    size_t   nSats = 0;
+    int32_t  prn[4] = { 0 };
+    int32_t  elevation[4] = { 0 };
+    int32_t  azimuth[4] = { 0 };
+    int32_t  snr[4] = { 0 };
+    uint32_t checksum = 0;
+    int16_t  n = strsepf(test, format, &total, &nSats, prn, elevation, azimuth, snr, &checksum);
+
+    TEST_ASSERT_EQUAL(3, n);
+    TEST_ASSERT_EQUAL(10, total);
+    TEST_ASSERT_EQUAL(2, nSats);
+    TEST_ASSERT_EQUAL(29, prn[0]);
+    TEST_ASSERT_EQUAL(9, elevation[0]);
+    TEST_ASSERT_EQUAL(301, azimuth[0]);
+    TEST_ASSERT_EQUAL(24, snr[0]);
+    TEST_ASSERT_EQUAL(30, prn[1]);
+    TEST_ASSERT_EQUAL(12, elevation[1]);
+    TEST_ASSERT_EQUAL(40, azimuth[1]);
+    TEST_ASSERT_EQUAL(44, snr[1]);
+    TEST_ASSERT_EQUAL(0x74, checksum);
+}
+
+void
+test_strsepf_group_gpgsa_strings()
+{
+    char              test[] = "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39";
+    char const* const format = "$GPGSA,%*s,%*d,%{%s,}12%s,%*s,%s*";
+
+    size_t nIds = 0;
+    char*  ids[12] = { NULL };
+    char*  pdop = NULL;
+    char*  vdop = NULL;
+    int16_t n = strsepf(test, format, &nIds, ids, &pdop, &vdop);
+
+    TEST_ASSERT_EQUAL(3, n);
+    TEST_ASSERT_EQUAL(12, nIds);
+    TEST_ASSERT_EQUAL_STRING("04", ids[0]);
+    TEST_ASSERT_EQUAL_STRING("", ids[2]);
+    TEST_ASSERT_EQUAL_STRING("24", ids[7]);
+    TEST_ASSERT_EQUAL_STRING("", ids[11]);
+    TEST_ASSERT_EQUAL_STRING("2.5", pdop);
+    TEST_ASSERT_EQUAL_STRING("2.1", vdop);
+}
+
+void
+test_strsepf_group_until_end_of_input()
+{
+    char              test[] = "list:1,2,3";
+    char const* const format = "list:%{%u,}8";
+
+    size_t   nValues = 0;
+    uint32_t values[8] = { 0 };
+    int16_t  n = strsepf(test, format, &nValues, values);
+
+    TEST_ASSERT_EQUAL(1, n);
+    TEST_ASSERT_EQUAL(3, nValues);
+    TEST_ASSERT_EQUAL(1, values[0]);
+    TEST_ASSERT_EQUAL(2, values[1]);
+    TEST_ASSERT_EQUAL(3, values[2]);
+}
+
+void
+test_strsepf_group_last_delimiter_missing()
+{
+    char    test0[] = "1,2,3";
+    char    test1[] = "1,2,3,";
+    size_t  nValues0 = 0;
+    size_t  nValues1 = 0;
+    int32_t values0[8] = { 0 };
+    int32_t values1[8] = { 0 };
+    int16_t n0 = strsepf(test0, "%{%d,}8", &nValues0, values0);
+    int16_t n1 = strsepf(test1, "%{%d,}8", &nValues1, values1);
+
+    TEST_ASSERT_EQUAL(1, n0);
+    TEST_ASSERT_EQUAL(1, n1);
+    TEST_ASSERT_EQUAL(3, nValues0);
+    TEST_ASSERT_EQUAL(3, nValues1);
+    TEST_ASSERT_EQUAL_INT32_ARRAY(values1, values0, 8);
+
+    // Only the delimiter of the last field can be missing
+    char     test2[] = "1,2;3,4";
+    char     test3[] = "1,2;3";
+    size_t   nPairs = 0;
+    uint32_t first[8] = { 0 };
+    uint32_t second[8] = { 0 };
+    TEST_ASSERT_EQUAL(1, strsepf(test2, "%{%u,%u;}8", &nPairs, first, second));
+    TEST_ASSERT_EQUAL(2, nPairs);
+    TEST_ASSERT_EQUAL(3, first[1]);
+    TEST_ASSERT_EQUAL(4, second[1]);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INPUT_DOESNT_MATCH_FORMAT,
+                      strsepf(test3, "%{%u,%u;}8", &nPairs, first, second));
+}
+
+void
+test_strsepf_group_more_than_capacity()
+{
+    char              test[] = "1,2,3;";
+    char const* const format = "%{%u,}2;";
+
+    size_t   nValues = 0;
+    uint32_t values[2] = { 0 };
+    int16_t  n = strsepf(test, format, &nValues, values);
+
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INPUT_DOESNT_MATCH_FORMAT, n);
+    TEST_ASSERT_EQUAL(1, values[0]);
+    TEST_ASSERT_EQUAL(2, values[1]);
+}
+
+void
+test_strsepf_group_incomplete_repetition()
+{
+    char              test[] = "1,2,3*";
+    char const* const format = "%{%u,%u,}4*";
+
+    size_t   nValues = 0;
+    uint32_t first[4] = { 0 };
+    uint32_t second[4] = { 0 };
+    int16_t  n = strsepf(test, format, &nValues, first, second);
+
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INPUT_DOESNT_MATCH_FORMAT, n);
+}
+
+void
+test_strsepf_group_invalid_format()
+{
+    char    test0[] = "1,2";
+    size_t  nValues = 0;
+    int32_t values[2] = { 0 };
+
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_FORMAT, strsepf(test0, "%{%d,}", &nValues, values));
+
+    char test1[] = "1,2";
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_FORMAT, strsepf(test1, "%{%d,2", &nValues, values));
+
+    char test2[] = "1,2";
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_FORMAT,
+                      strsepf(test2, "%{%{%d,}2}2", &nValues, values));
+
+    char test3[] = "1,2";
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_ARGS, strsepf(test3, "%{%d,}2", &nValues, NULL));
+
+    char test4[] = "1,2;";
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_FORMAT,
+                      strsepf(test4, "%{%d,}99999999999;", &nValues, values)); //< > UINT32_MAX
+}
+
+void
+test_strsepf_group_empty_list()
+{
+    char     test[] = "list:";
+    size_t   nValues = 42;
+    uint32_t values[8] = { 0 };
+
+    int16_t n = strsepf(test, "list:%{%u,}8", &nValues, values);
+    TEST_ASSERT_EQUAL(1, n);
+    TEST_ASSERT_EQUAL(0, nValues);
+
+    char    msg[] = "$GPGSV,1,1,00,";
+    size_t  nSats = 42;
+    int32_t prn[4], elevation[4], azimuth[4], snr[4];
+    n = strsepf(msg, "$GPGSV,%*d,%*d,%*d,%{%d,%d,%d,%d,}4*%*x", &nSats, prn, elevation, azimuth, snr);
+    TEST_ASSERT_EQUAL(1, n);
+    TEST_ASSERT_EQUAL(0, nSats);
+}
+
+//-----------------------------------------------------------
+//
+// Key/value tests
+//
+//-----------------------------------------------------------
+void
+test_strsepf_kv_any_order()
+{
+    strsepf_kv kv;
+    TEST_ASSERT_EQUAL(3, strsepf_kv_compile(&kv, "id=%d name=%s level=%u"));
+
+    char     test[] = "level=3 host=a12 name=pump id=-7";
+    int32_t  answer0 = 0;
+    char*    answer1 = NULL;
+    uint32_t answer2 = 0;
+    int16_t  n = strsepf_kv_parse(&kv, test, &answer0, &answer1, &answer2);
+
+    TEST_ASSERT_EQUAL(3, n);
+    TEST_ASSERT_EQUAL(-7, answer0);
+    TEST_ASSERT_EQUAL_STRING("pump", answer1);
+    TEST_ASSERT_EQUAL(3, answer2);
+}
+
+void
+test_strsepf_kv_reuse_compiled_format()
+{
+    strsepf_kv kv;
+    TEST_ASSERT_EQUAL(2, strsepf_kv_compile(&kv, "t:%u,mask:%x"));
+
+    uint32_t answer0 = 0;
+    uint32_t answer1 = 0;
+
+    char    test0[] = "mask:0xFF,t:12";
+    int16_t n = strsepf_kv_parse(&kv, test0, &answer0, &answer1);
+    TEST_ASSERT_EQUAL(2, n);
+    TEST_ASSERT_EQUAL(12, answer0);
+    TEST_ASSERT_EQUAL(0xFF, answer1);
+
+    char test1[] = ",,junk,t:99,other:1";
+    n = strsepf_kv_parse(&kv, test1, &answer0, &answer1);
+    TEST_ASSERT_EQUAL(1, n);
+    TEST_ASSERT_EQUAL(99, answer0);
+}
+
+void
+test_strsepf_kv_optional_specifiers()
+{
+    strsepf_kv kv;
+    TEST_ASSERT_EQUAL(3, strsepf_kv_compile(&kv, "dev=%?s seq=%*d msg=%4s"));
+
+    strsepf_predicate const isPump = { .type = STRSEPF_PREDICATE_EQUAL, .str = "pump" };
+
+    char*   answer0 = NULL;
+    char*   answer1 = NULL;
+    char    test0[] = "seq=1 msg=ok dev=pump";
+    int16_t n = strsepf_kv_parse(&kv, test0, &isPump, &answer0, &answer1);
+    TEST_ASSERT_EQUAL(2, n);
+    TEST_ASSERT_EQUAL_STRING("pump", answer0);
+    TEST_ASSERT_EQUAL_STRING("ok", answer1);
+
+    char test1[] = "dev=fan msg=ok";
+    n = strsepf_kv_parse(&kv, test1, &isPump, &answer0, &answer1);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_PREDICATE_REJECTED, n);
+
+    char test2[] = "msg=toolong";
+    n = strsepf_kv_parse(&kv, test2, &isPump, &answer0, &answer1);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_TOKEN_IS_BIGGER_THAN_WIDTH, n);
+}
+
+void
+test_strsepf_kv_conversion_error()
+{
+    strsepf_kv kv;
+    TEST_ASSERT_EQUAL(1, strsepf_kv_compile(&kv, "id=%d"));
+
+    int32_t answer0 = 0;
+    char    test[] = "id=12ab";
+    int16_t n = strsepf_kv_parse(&kv, test, &answer0);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_STRTOI_EXTRA_CHAR, n);
+}
+
+void
+test_strsepf_kv_invalid_format()
+{
+    strsepf_kv kv;
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_FORMAT, strsepf_kv_compile(&kv, ""));
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_FORMAT, strsepf_kv_compile(&kv, "id=%d id=%d"));
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_FORMAT, strsepf_kv_compile(&kv, "a=%d b:%d"));
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_FORMAT, strsepf_kv_compile(&kv, "a=%d,b=%d c=%d"));
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_FORMAT, strsepf_kv_compile(&kv, "=%d"));
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_FORMAT, strsepf_kv_compile(&kv, "a=%j"));
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_PARAMETER, strsepf_kv_compile(NULL, "a=%d"));
+}
+
+void
+test_strsepf_kv_many_keys()
+{
+    strsepf_kv kv;
+    TEST_ASSERT_EQUAL(16, strsepf_kv_compile(&kv,
+                                             "a=%u b=%u c=%u d=%u e=%u f=%u g=%u h=%u "
+                                             "i=%u j=%u k=%u l=%u m=%u n=%u o=%u p=%u"));
+
+    uint32_t v[16] = { 0 };
+    char     test[] = "p=15 o=14 n=13 m=12 l=11 k=10 j=9 i=8 h=7 g=6 f=5 e=4 d=3 c=2 b=1 a=0";
+    int16_t  n = strsepf_kv_parse(&kv, test, &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7],
+                                  &v[8], &v[9], &v[10], &v[11], &v[12], &v[13], &v[14], &v[15]);
+
+    TEST_ASSERT_EQUAL(16, n);
+    for (uint32_t i = 0; i < 16; i++) {
+        TEST_ASSERT_EQUAL(i, v[i]);
+    }
+}
+
+//-----------------------------------------------------------
+//
+// Arena tests
+//
+//-----------------------------------------------------------
+void
+test_strsepf_copy_outlives_input()
+{
+    char          memory[64];
+    strsepf_arena arena;
+    strsepf_arena_init(&arena, memory, sizeof(memory));
+
+    char     test[] = "pump,42,north";
+    char*    answer0 = NULL;
+    uint32_t answer1 = 0;
+    char*    answer2 = NULL;
+    int16_t  n = strsepf_copy(&arena, test, "%s,%u,%s", &answer0, &answer1, &answer2);
+    memset(test, 'x', sizeof(test) - 1); //< Recycle the input buffer
+
+    TEST_ASSERT_EQUAL(3, n);
+    TEST_ASSERT_EQUAL_STRING("pump", answer0);
+    TEST_ASSERT_EQUAL(42, answer1);
+    TEST_ASSERT_EQUAL_STRING("north", answer2);
+    TEST_ASSERT_EQUAL(sizeof("pump") + sizeof("north"), arena.used);
+    TEST_ASSERT_TRUE(answer0 == &memory[0]);
+    TEST_ASSERT_TRUE(answer2 == &memory[sizeof("pump")]);
+}
+
+void
+test_strsepf_copy_arena_full()
+{
+    char          memory[8];
+    strsepf_arena arena;
+    strsepf_arena_init(&arena, memory, sizeof(memory));
+
+    char    test0[] = "abc,defgh";
+    char*   answer0 = NULL;
+    char*   answer1 = NULL;
+    int16_t n = strsepf_copy(&arena, test0, "%s,%s", &answer0, &answer1);
+
+    // On error, the arena is left as it was
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_ARENA_FULL, n);
+    TEST_ASSERT_EQUAL(0, arena.used);
+
+    char test1[] = "abc,def";
+    n = strsepf_copy(&arena, test1, "%s,%s", &answer0, &answer1);
+    TEST_ASSERT_EQUAL(2, n);
+    TEST_ASSERT_EQUAL(8, arena.used);
+
+    // Full until reset
+    char test2[] = "a";
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_ARENA_FULL, strsepf_copy(&arena, test2, "%s", &answer0));
+    strsepf_arena_reset(&arena);
+    char test3[] = "a";
+    TEST_ASSERT_EQUAL(1, strsepf_copy(&arena, test3, "%s", &answer0));
+    TEST_ASSERT_EQUAL_STRING("a", answer0);
+
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_PARAMETER, strsepf_copy(NULL, test3, "%s", &answer0));
+}
+
+void
+test_strsepf_copy_group()
+{
+    char          memory[32];
+    strsepf_arena arena;
+    strsepf_arena_init(&arena, memory, sizeof(memory));
+
+    char    test[] = "ids:a1;b2;c3.";
+    size_t  count = 0;
+    char*   ids[4] = { NULL };
+    int16_t n = strsepf_copy(&arena, test, "ids:%{%s;}4.", &count, ids);
+    memset(test, 'x', sizeof(test) - 1);
+
+    TEST_ASSERT_EQUAL(1, n);
+    TEST_ASSERT_EQUAL(3, count);
+    TEST_ASSERT_EQUAL_STRING("a1", ids[0]);
+    TEST_ASSERT_EQUAL_STRING("b2", ids[1]);
+    TEST_ASSERT_EQUAL_STRING("c3", ids[2]);
+    TEST_ASSERT_EQUAL(9, arena.used);
+}
+
+//-----------------------------------------------------------
+//
+// Interning tests
+//
+//-----------------------------------------------------------
+void
+test_strsepf_intern_repeated_strings()
+{
+    uint32_t       slots[16];
+    char const*    strs[16];
+    char           memory[64];
+    strsepf_intern units;
+    int16_t        rc = strsepf_intern_init(&units, slots, strs, 16, memory, sizeof(memory));
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_OK, rc);
+
+    char const* const format = "$%*sBWC,%*d,%*s,%*s,%*s,%*s,%*s,%k,%*s,%k,%*s,%k,";
+    char              test0[] = "$GPBWC,081837,,,,,,T,,M,,N,*13";
+    char              test1[] = "$GPBWC,081838,,,,,,T,,T,,M,*13";
+
+    uint32_t unit0[3] = { 0 };
+    uint32_t unit1[3] = { 0 };
+    int16_t  n0 = strsepf(test0, format, &units, &unit0[0], &units, &unit0[1], &units, &unit0[2]);
+    int16_t  n1 = strsepf(test1, format, &units, &unit1[0], &units, &unit1[1], &units, &unit1[2]);
+    TEST_ASSERT_EQUAL(3, n0);
+    TEST_ASSERT_EQUAL(3, n1);
+
+    // Stored once, dense ids
+    TEST_ASSERT_EQUAL(3, units.nIds);
+    TEST_ASSERT_EQUAL(0, unit0[0]);
+    TEST_ASSERT_EQUAL(1, unit0[1]);
+    TEST_ASSERT_EQUAL(2, unit0[2]);
+    TEST_ASSERT_EQUAL(0, unit1[0]);
+    TEST_ASSERT_EQUAL(0, unit1[1]);
+    TEST_ASSERT_EQUAL(1, unit1[2]);
+    TEST_ASSERT_EQUAL_STRING("T", strsepf_intern_str(&units, 0));
+    TEST_ASSERT_EQUAL_STRING("N", strsepf_intern_str(&units, 2));
+    TEST_ASSERT_TRUE(strsepf_intern_str(&units, 3) == NULL);
+    TEST_ASSERT_EQUAL(6, units.arena.used);
+}
+
+void
+test_strsepf_intern_full()
+{
+    uint32_t       slots[4];
+    char const*    strs[4];
+    char           memory[64];
+    strsepf_intern names;
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_PARAMETER,
+                      strsepf_intern_init(&names, slots, strs, 3, memory, sizeof(memory)));
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_OK,
+                      strsepf_intern_init(&names, slots, strs, 4, memory, sizeof(memory)));
+
+    // Up to 3/4 of the slots
+    TEST_ASSERT_EQUAL(0, strsepf_intern_id(&names, "a"));
+    TEST_ASSERT_EQUAL(1, strsepf_intern_id(&names, "b"));
+    TEST_ASSERT_EQUAL(2, strsepf_intern_id(&names, "c"));
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INTERN_FULL, strsepf_intern_id(&names, "d"));
+    TEST_ASSERT_EQUAL(1, strsepf_intern_id(&names, "b"));
+
+    char     test[] = "pump;d";
+    uint32_t id = 0;
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INTERN_FULL, strsepf(test, "%k;%*s", &names, &id));
+
+    // Storage full
+    char mini[4];
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_OK,
+                      strsepf_intern_init(&names, slots, strs, 4, mini, sizeof(mini)));
+    TEST_ASSERT_EQUAL(0, strsepf_intern_id(&names, "abc"));
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_ARENA_FULL, strsepf_intern_id(&names, "x"));
+}
+
+void
+test_strsepf_intern_group_and_kv()
+{
+    uint32_t       slots[8];
+    char const*    strs[8];
+    char           memory[64];
+    strsepf_intern hosts;
+    strsepf_intern_init(&hosts, slots, strs, 8, memory, sizeof(memory));
+
+    char     test[] = "hosts:a12,b7,a12;";
+    size_t   nHosts = 0;
+    uint32_t ids[4] = { 0 };
+    TEST_ASSERT_EQUAL(1, strsepf(test, "hosts:%{%k,}4;", &nHosts, &hosts, ids));
+    TEST_ASSERT_EQUAL(3, nHosts);
+    TEST_ASSERT_EQUAL(0, ids[0]);
+    TEST_ASSERT_EQUAL(1, ids[1]);
+    TEST_ASSERT_EQUAL(0, ids[2]);
+
+    strsepf_kv kv;
+    TEST_ASSERT_EQUAL(2, strsepf_kv_compile(&kv, "id=%d host=%k"));
+    char     line[] = "host=b7 id=3";
+    int32_t  value = 0;
+    uint32_t host = 0;
+    TEST_ASSERT_EQUAL(2, strsepf_kv_parse(&kv, line, &value, &hosts, &host));
+    TEST_ASSERT_EQUAL(3, value);
+    TEST_ASSERT_EQUAL(1, host);
+}
+
+//-----------------------------------------------------------
+//
+// Diagnostics tests
+//
+//-----------------------------------------------------------
+void
+test_strsepf_diag_conversion_error()
+{
+    char              test[] = "$GPGGA,12x,4807\n$GPGGA,13,4808\n";
+    char const* const format = "$GPGGA,%d,%s\n";
+
+    strsepf_error_info info;
+    int32_t            time = 0;
+    char*              lat = NULL;
+    int16_t            n = strsepf_diag(&info, NULL, test, format, &time, &lat);
+
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_STRTOI_EXTRA_CHAR, n);
+    TEST_ASSERT_EQUAL(n, info.result);
+    TEST_ASSERT_EQUAL(7, info.inputOffset);
+    TEST_ASSERT_EQUAL(7, info.formatOffset);
+    TEST_ASSERT_TRUE(info.resync == &test[16]);
+
+    // Resume on the next record
+    n = strsepf_diag(&info, NULL, info.resync, format, &time, &lat);
+    TEST_ASSERT_EQUAL(2, n);
+    TEST_ASSERT_EQUAL(13, time);
+    TEST_ASSERT_EQUAL_STRING("4808", lat);
+}
+
+void
+test_strsepf_diag_literal_mismatch()
+{
+    char               test[] = "#GPGGA,1,a$GPGGA,2,b";
+    strsepf_error_info info;
+    int32_t            time = 0;
+    char*              lat = NULL;
+    int16_t            n = strsepf_diag(&info, NULL, test, "$GPGGA,%d,%s", &time, &lat);
+
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INPUT_DOESNT_MATCH_FORMAT, n);
+    TEST_ASSERT_EQUAL(0, info.inputOffset);
+    TEST_ASSERT_EQUAL(0, info.formatOffset);
+    TEST_ASSERT_TRUE(info.resync == &test[10]); //< The next record starts at '$'
+
+    // Burst without a line ending: the delimiter of the failed token is put back
+    char test1[] = "$GPGGA,1x$GPGGA,2,b";
+    n = strsepf_diag(&info, NULL, test1, "$GPGGA,%d,%s", &time, &lat);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_STRTOI_EXTRA_CHAR, n);
+    TEST_ASSERT_TRUE(info.resync == &test1[9]);
+    n = strsepf_diag(&info, NULL, info.resync, "$GPGGA,%d,%s", &time, &lat);
+    TEST_ASSERT_EQUAL(2, n);
+    TEST_ASSERT_EQUAL(2, time);
+
+    // Custom resync characters, no next record
+    char test2[] = "id=x;id=2";
+    n = strsepf_diag(&info, ";", test2, "id=%u;", &time);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_STRTOI_NOT_A_DECIMAL, n);
+    TEST_ASSERT_EQUAL(3, info.inputOffset);
+    TEST_ASSERT_EQUAL(3, info.formatOffset);
+    TEST_ASSERT_TRUE(info.resync == &test2[4]);
+
+    char test3[] = "id=x";
+    n = strsepf_diag(&info, ";", test3, "id=%u;", &time);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_STRTOI_NOT_A_DECIMAL, n);
+    TEST_ASSERT_NULL(info.resync);
+}
+
+void
+test_strsepf_diag_group()
+{
+    char              test[] = "$GPGSV,1,25,9x,3,\n$GPGSV";
+    char const* const format = "$GPGSV,%*d,%{%u,%u,}4\n";
+
+    strsepf_error_info info;
+    size_t             nSats = 0;
+    uint32_t           prn[4];
+    uint32_t           snr[4];
+    int16_t            n = strsepf_diag(&info, NULL, test, format, &nSats, prn, snr);
+
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_STRTOI_EXTRA_CHAR, n);
+    TEST_ASSERT_EQUAL(12, info.inputOffset);  //< "9x"
+    TEST_ASSERT_EQUAL(16, info.formatOffset); //< Second %u of the group
+    TEST_ASSERT_TRUE(info.resync == &test[18]);
+}
+
+//-----------------------------------------------------------
+//
+// Pipeline tests
+//
+//-----------------------------------------------------------
+void
+test_strsepf_ring_backpressure()
+{
+    char          storage[2 * 8];
+    strsepf_batch batches[2];
+    strsepf_ring  ring;
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_OK, strsepf_ring_init(&ring, storage, 8, batches, 2));
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_PARAMETER,
+                      strsepf_ring_init(&ring, storage, 8, batches, 3));
+
+    TEST_ASSERT_NULL(strsepf_ring_peek(&ring));
+
+    char* slot0 = strsepf_ring_acquire(&ring);
+    TEST_ASSERT_NOT_NULL(slot0);
+    strcpy(slot0, "a");
+    strsepf_ring_publish(&ring, 1, 0);
+
+    char* slot1 = strsepf_ring_acquire(&ring);
+    TEST_ASSERT_NOT_NULL(slot1);
+    strcpy(slot1, "b");
+    strsepf_ring_publish(&ring, 1, 1);
+
+    TEST_ASSERT_NULL(strsepf_ring_acquire(&ring)); //< Full
+
+    strsepf_batch* batch = strsepf_ring_peek(&ring);
+    TEST_ASSERT_NOT_NULL(batch);
+    TEST_ASSERT_EQUAL_STRING("a", batch->data);
+    TEST_ASSERT_EQUAL(0, batch->seq);
+    strsepf_ring_release(&ring);
+
+    TEST_ASSERT_EQUAL_PTR(slot0, strsepf_ring_acquire(&ring));
+    batch = strsepf_ring_peek(&ring);
+    TEST_ASSERT_EQUAL_STRING("b", batch->data);
+    TEST_ASSERT_EQUAL(1, batch->seq);
+}
+
+void
+test_strsepf_reader_record_aligned()
+{
+    int fds[2];
+    TEST_ASSERT_EQUAL(0, pipe(fds));
+
+    char          storage[2][16];
+    strsepf_batch batches[2][1];
+    strsepf_ring  rings[2];
+    strsepf_ring_init(&rings[0], storage[0], 16, batches[0], 1);
+    strsepf_ring_init(&rings[1], storage[1], 16, batches[1], 1);
+
+    char           carry[16];
+    strsepf_reader reader;
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_OK, strsepf_reader_init(&reader, fds[0], carry, 16));
+
+    char const input[] = "1,10\n2,20\n3,3";
+    TEST_ASSERT_EQUAL(sizeof(input) - 1, write(fds[1], input, sizeof(input) - 1));
+
+    // Only the complete records are published, to the first ring
+    TEST_ASSERT_EQUAL(10, strsepf_reader_step(&reader, rings, 2));
+
+    // The incomplete record is completed by the next read, published to the second ring
+    TEST_ASSERT_EQUAL(3, write(fds[1], "0\n4", 3));
+    TEST_ASSERT_EQUAL(5, strsepf_reader_step(&reader, rings, 2));
+
+    // Both rings are full
+    TEST_ASSERT_EQUAL(1, write(fds[1], "\n", 1));
+    TEST_ASSERT_EQUAL(0, strsepf_reader_step(&reader, rings, 2));
+
+    uint32_t       sum = 0;
+    strsepf_batch* batch = strsepf_ring_peek(&rings[0]);
+    char*          cursor = batch->data;
+    char*          record;
+    while ((record = strsepf_batch_next(batch, &cursor)) != NULL) {
+        uint32_t id = 0;
+        uint32_t value = 0;
+        TEST_ASSERT_EQUAL(2, strsepf(record, "%u,%u", &id, &value));
+        sum += value;
+    }
+    TEST_ASSERT_EQUAL(30, sum);
+    strsepf_ring_release(&rings[0]);
+
+    batch = strsepf_ring_peek(&rings[1]);
+    TEST_ASSERT_EQUAL(1, batch->seq);
+    TEST_ASSERT_EQUAL_STRING("3,30\n", batch->data);
+    strsepf_ring_release(&rings[1]);
+
+    // End of input
+    close(fds[1]);
+    TEST_ASSERT_EQUAL(2, strsepf_reader_step(&reader, rings, 2));
+    TEST_ASSERT_EQUAL(0, strsepf_reader_step(&reader, rings, 2));
+    TEST_ASSERT_TRUE(reader.eof);
+    close(fds[0]);
+}
+
+void
+test_strsepf_reader_record_too_long()
+{
+    int fds[2];
+    TEST_ASSERT_EQUAL(0, pipe(fds));
+
+    char          storage[8];
+    strsepf_batch batches[1];
+    strsepf_ring  ring;
+    strsepf_ring_init(&ring, storage, 8, batches, 1);
+
+    char           carry[8];
+    strsepf_reader reader;
+    strsepf_reader_init(&reader, fds[0], carry, 8);
+
+    TEST_ASSERT_EQUAL(10, write(fds[1], "0123456789", 10));
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_RECORD_TOO_LONG, strsepf_reader_step(&reader, &ring, 1));
+    close(fds[0]);
+    close(fds[1]);
+}
+
+void
+test_strsepf_reader_ring_sizes()
+{
+    int fds[2];
+    TEST_ASSERT_EQUAL(0, pipe(fds));
+
+    char          storage[2][16];
+    strsepf_batch batches[2][1];
+    strsepf_ring  rings[2];
+    strsepf_ring_init(&rings[0], storage[0], 16, batches[0], 1);
+    strsepf_ring_init(&rings[1], storage[1], 8, batches[1], 1);
+
+    char           carry[16];
+    strsepf_reader reader;
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_PARAMETER, strsepf_reader_init(&reader, fds[0], carry, 1));
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_OK, strsepf_reader_init(&reader, fds[0], carry, 16));
+
+    // A carry from a 16 bytes slot wouldn't fit in a 8 bytes slot
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INVALID_PARAMETER, strsepf_reader_step(&reader, rings, 2));
+
+    // The next ring only changes when a batch is published
+    strsepf_ring_init(&rings[1], storage[1], 16, batches[1], 1);
+    TEST_ASSERT_EQUAL(3, write(fds[1], "1,1", 3));
+    TEST_ASSERT_EQUAL(0, strsepf_reader_step(&reader, rings, 2)); //< No complete record
+    TEST_ASSERT_EQUAL(2, write(fds[1], "0\n", 2));
+    TEST_ASSERT_EQUAL(5, strsepf_reader_step(&reader, rings, 2));
+    TEST_ASSERT_NOT_NULL(strsepf_ring_peek(&rings[0]));
+    TEST_ASSERT_NULL(strsepf_ring_peek(&rings[1]));
+    close(fds[0]);
+    close(fds[1]);
+}
+
+typedef struct
+{
+    strsepf_ring* ring;
+    atomic_bool*  done;
+    uint64_t      sum;
+    uint64_t      nextSeq;
+    bool          inOrder;
+} test_worker;
+
+static void*
+test_worker_run(void* arg)
+{
+    test_worker* worker = arg;
+    for (;;) {
+        strsepf_batch* batch = strsepf_ring_peek(worker->ring);
+        if (batch == NULL) {
+            if (atomic_load(worker->done) && strsepf_ring_peek(worker->ring) == NULL) {
+                break;
+            }
+            continue;
+        }
+        worker->inOrder = worker->inOrder && (batch->seq == worker->nextSeq++);
+
+        char* cursor = batch->data;
+        char* record;
+        while ((record = strsepf_batch_next(batch, &cursor)) != NULL) {
+            uint32_t value = 0;
+            if (strsepf(record, "%*u,%u", &value) == 1) {
+                worker->sum += value;
+            }
+        }
+        strsepf_ring_release(worker->ring);
+    }
+    return NULL;
+}
+
+void
+test_strsepf_pipeline_threads()
+{
+    int fds[2];
+    TEST_ASSERT_EQUAL(0, pipe(fds));
+
+    uint64_t expected = 0;
+    for (uint32_t i = 0; i < 2000; i++) {
+        char line[32];
+        int  len = snprintf(line, sizeof(line), "%u,%u\n", i, 3 * i);
+        TEST_ASSERT_EQUAL(len, write(fds[1], line, (size_t)len));
+        expected += 3 * i;
+    }
+    close(fds[1]);
+
+    static char   storage[4 * 64];
+    strsepf_batch batches[4];
+    strsepf_ring  ring;
+    strsepf_ring_init(&ring, storage, 64, batches, 4);
+
+    atomic_bool done;
+    atomic_init(&done, false);
+    test_worker worker = { .ring = &ring, .done = &done, .inOrder = true };
+    pthread_t   thread;
+    TEST_ASSERT_EQUAL(0, pthread_create(&thread, NULL, test_worker_run, &worker));
+
+    char           carry[64];
+    strsepf_reader reader;
+    strsepf_reader_init(&reader, fds[0], carry, 64);
+    while (!reader.eof) {
+        TEST_ASSERT_TRUE(strsepf_reader_step(&reader, &ring, 1) >= 0);
+    }
+    atomic_store(&done, true);
+    pthread_join(thread, NULL);
+    close(fds[0]);
+
+    TEST_ASSERT_EQUAL(expected, worker.sum);
+    TEST_ASSERT_TRUE(worker.inOrder);
+}
+
+typedef struct
+{
+    uint32_t id;
+    uint32_t value;
+} test_parsed;
+
+static int16_t
+test_parse_record(char* record, void* parsed, void const* ctx)
+{
+    test_parsed* out = parsed;
+    return strsepf(record, ctx, &out->id, &out->value);
+}
+
+typedef struct
+{
+    strsepf_worker* worker;
+    atomic_bool*    done;
+    atomic_bool     finished;
+} test_worker_thread;
+
+static void*
+test_worker_thread_run(void* arg)
+{
+    test_worker_thread* thread = arg;
+    for (;;) {
+        bool const inputDone = atomic_load(thread->done);
+        if (strsepf_worker_step(thread->worker) == 0 && thread->worker->batch == NULL && inputDone &&
+            strsepf_ring_peek(thread->worker->in) == NULL) {
+            break;
+        }
+    }
+    atomic_store(&thread->finished, true);
+    return NULL;
+}
+
+void
+test_strsepf_pipeline_workers()
+{
+    int fds[2];
+    TEST_ASSERT_EQUAL(0, pipe(fds));
+
+    uint64_t expected = 0;
+    for (uint32_t i = 0; i < 2000; i++) {
+        char line[32];
+        int  len = snprintf(line, sizeof(line), (i % 100 == 7) ? "%u,x%u\n" : "%u,%u\n", i, 3 * i);
+        TEST_ASSERT_EQUAL(len, write(fds[1], line, (size_t)len));
+        expected += (i % 100 == 7) ? 0 : 3 * i;
+    }
+    close(fds[1]);
+
+    // 2 workers: input batches of 64 bytes, output batches of 2 parsed records
+    enum { nWorkers = 2 };
+    static char        inStorage[nWorkers][4 * 64];
+    static test_parsed outStorage[nWorkers][4 * 2];
+    strsepf_batch      inBatches[nWorkers][4];
+    strsepf_batch      outBatches[nWorkers][4];
+    strsepf_ring       in[nWorkers];
+    strsepf_ring       out[nWorkers];
+    strsepf_worker     workers[nWorkers];
+    test_worker_thread threads[nWorkers];
+    pthread_t          ids[nWorkers];
+
+    atomic_bool done;
+    atomic_init(&done, false);
+    for (size_t i = 0; i < nWorkers; i++) {
+        strsepf_ring_init(&in[i], inStorage[i], 64, inBatches[i], 4);
+        strsepf_ring_init(&out[i], (char*)outStorage[i], 2 * sizeof(test_parsed), outBatches[i], 4);
+        TEST_ASSERT_EQUAL(STRSEPF_RESULT_OK,
+                          strsepf_worker_init(&workers[i], &in[i], &out[i], sizeof(test_parsed),
+                                              test_parse_record, "%u,%u"));
+        threads[i].worker = &workers[i];
+        threads[i].done = &done;
+        atomic_init(&threads[i].finished, false);
+        TEST_ASSERT_EQUAL(0, pthread_create(&ids[i], NULL, test_worker_thread_run, &threads[i]));
+    }
+
+    // Read and consume the parsed records on this thread
+    char           carry[64];
+    strsepf_reader reader;
+    strsepf_reader_init(&reader, fds[0], carry, 64);
+
+    uint64_t sum = 0;
+    uint32_t nRecords = 0;
+    uint64_t lastSeq[nWorkers] = { 0 };
+    bool     inOrder = true;
+    for (;;) {
+        if (!reader.eof) {
+            TEST_ASSERT_TRUE(strsepf_reader_step(&reader, in, nWorkers) >= 0);
+            atomic_store(&done, reader.eof);
+        }
+        bool const finished = atomic_load(&threads[0].finished) && atomic_load(&threads[1].finished);
+
+        for (size_t i = 0; i < nWorkers; i++) {
+            strsepf_batch* batch;
+            while ((batch = strsepf_ring_peek(&out[i])) != NULL) {
+                inOrder = inOrder && (batch->seq >= lastSeq[i]); //< In order within a ring
+                lastSeq[i] = batch->seq;
+
+                test_parsed const* parsed = (test_parsed const*)batch->data;
+                for (size_t r = 0; r < batch->len / sizeof(test_parsed); r++) {
+                    sum += parsed[r].value;
+                    nRecords++;
+                }
+                strsepf_ring_release(&out[i]);
+            }
+        }
+        if (finished) {
+            break;
+        }
+    }
+    for (size_t i = 0; i < nWorkers; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    close(fds[0]);
+
+    TEST_ASSERT_TRUE(inOrder);
+    TEST_ASSERT_EQUAL(expected, sum);
+    TEST_ASSERT_EQUAL(2000 - 20, nRecords);
+    TEST_ASSERT_EQUAL(20, workers[0].dropped + workers[1].dropped);
+}
+
+//-----------------------------------------------------------
+//
+// Ingestion tests
+//
+//-----------------------------------------------------------
+typedef struct
+{
+    uint64_t sum[3];
+    uint32_t errors;
+} test_ingest_ctx;
+
+static void
+test_ingest_on_record(char* record, size_t file, void* ctx)
+{
+    test_ingest_ctx* totals = ctx;
+    uint32_t         value = 0;
+    if (strsepf(record, "v=%u", &value) == 1) {
+        totals->sum[file] += value;
+    } else {
+        totals->errors++;
+    }
+}
+
+static void
+test_ingest_write_file(char path[], char const* content)
+{
+    int fd = mkstemp(path);
+    TEST_ASSERT_TRUE(fd >= 0);
+    TEST_ASSERT_EQUAL(strlen(content), write(fd, content, strlen(content)));
+    close(fd);
+}
+
+static void
+test_ingest_backend(strsepf_ingest_backend backend)
+{
+    char file0[] = "/tmp/strsepf_ingest_XXXXXX";
+    char file1[] = "/tmp/strsepf_ingest_XXXXXX";
+    test_ingest_write_file(file0, "v=1\nv=2\nv=30\nv=400\n");
+    test_ingest_write_file(file1, "v=5\nv=6"); //< No final delimiter
+
+    char const* const paths[] = { file0, "/tmp/strsepf_ingest_does_not_exist", file1 };
+    char              buffers[2 * 8]; //< Small buffers: records are split across reads
+    test_ingest_ctx   totals = { { 0 }, 0 };
+
+    strsepf_ingest_config const config = {
+        .buffers = buffers,
+        .bufferSize = 8,
+        .nInflight = 2,
+        .backend = backend,
+        .onRecord = test_ingest_on_record,
+        .ctx = &totals,
+    };
+    strsepf_ingest_stats stats[3];
+    int32_t              n = strsepf_ingest(&config, paths, 3, stats);
+    unlink(file0);
+    unlink(file1);
+    if (n == STRSEPF_RESULT_ERR_IO && backend == STRSEPF_INGEST_IO_URING) {
+        return; //< io_uring not available on this system
+    }
+
+    TEST_ASSERT_EQUAL(2, n);
+    TEST_ASSERT_EQUAL(0, totals.errors);
+    TEST_ASSERT_EQUAL(433, totals.sum[0]);
+    TEST_ASSERT_EQUAL(11, totals.sum[2]);
+
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_OK, stats[0].result);
+    TEST_ASSERT_EQUAL(19, stats[0].bytes);
+    TEST_ASSERT_EQUAL(4, stats[0].records);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_IO, stats[1].result);
+    TEST_ASSERT_EQUAL(ENOENT, stats[1].errnum);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_OK, stats[2].result);
+    TEST_ASSERT_EQUAL(7, stats[2].bytes);
+    TEST_ASSERT_EQUAL(2, stats[2].records);
+}
+
+void
+test_strsepf_ingest_pread()
+{
+    test_ingest_backend(STRSEPF_INGEST_PREAD);
+}
+
+void
+test_strsepf_ingest_io_uring()
+{
+    test_ingest_backend(STRSEPF_INGEST_IO_URING);
+}
+
+void
+test_strsepf_ingest_auto()
+{
+    test_ingest_backend(STRSEPF_INGEST_AUTO);
+}
+
+// io_uring submissions number [failFrom, failFrom + failCount) fail with `errnum`.
+static struct
+{
+    strsepf_ingest_enter_fn_ enter;
+    unsigned                 calls;
+    unsigned                 failFrom;
+    unsigned                 failCount;
+    int                      errnum;
+} test_ingest_faults;
+
+static int
+test_ingest_faulty_enter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    if (toSubmit > 0) {
+        unsigned const call = test_ingest_faults.calls++;
+        if (call >= test_ingest_faults.failFrom &&
+            call < test_ingest_faults.failFrom + test_ingest_faults.failCount) {
+            errno = test_ingest_faults.errnum;
+            return -1;
+        }
+    }
+    return test_ingest_faults.enter(ringFd, toSubmit, minComplete, flags);
+}
+
+static int32_t
+test_ingest_with_faults(unsigned              failFrom,
+                        unsigned              failCount,
+                        int                   errnum,
+                        test_ingest_ctx*      totals,
+                        strsepf_ingest_stats* stats)
+{
+    char file0[] = "/tmp/strsepf_ingest_XXXXXX";
+    char file1[] = "/tmp/strsepf_ingest_XXXXXX";
+    char file2[] = "/tmp/strsepf_ingest_XXXXXX";
+    test_ingest_write_file(file0, "v=1\nv=2\nv=30\nv=400\n");
+    test_ingest_write_file(file1, "v=5\nv=6\nv=70\nv=800\n");
+    test_ingest_write_file(file2, "v=9\nv=10\n");
+
+    char const* const paths[] = { file0, file1, file2 };
+    char              buffers[2 * 8];
+
+    strsepf_ingest_config const config = {
+        .buffers = buffers,
+        .bufferSize = 8,
+        .nInflight = 2,
+        .backend = STRSEPF_INGEST_IO_URING,
+        .onRecord = test_ingest_on_record,
+        .ctx = totals,
+    };
+    test_ingest_faults.enter = strsepf_ingest_enter_;
+    test_ingest_faults.calls = 0;
+    test_ingest_faults.failFrom = failFrom;
+    test_ingest_faults.failCount = failCount;
+    test_ingest_faults.errnum = errnum;
+    strsepf_ingest_enter_ = test_ingest_faulty_enter;
+
+    int32_t n = strsepf_ingest(&config, paths, 3, stats);
+
+    strsepf_ingest_enter_ = test_ingest_faults.enter;
+    unlink(file0);
+    unlink(file1);
+    unlink(file2);
+    return n;
+}
+
+void
+test_strsepf_ingest_io_uring_enter_failure()
+{
+    uint64_t const expected[3] = { 433, 881, 19 };
+
+    // Interrupted submission: retried
+    test_ingest_ctx      totals = { { 0 }, 0 };
+    strsepf_ingest_stats stats[3];
+    int32_t              n = test_ingest_with_faults(1, 1, EINTR, &totals, stats);
+    if (n == STRSEPF_RESULT_ERR_IO) {
+        return; //< io_uring not available on this system
+    }
+    TEST_ASSERT_EQUAL(3, n);
+    TEST_ASSERT_EQUAL(0, totals.errors);
+    for (size_t i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(expected[i], totals.sum[i]);
+    }
+
+    // Failed submission of a second read: only that file fails, and its read
+    // never reaches the file opened next in its buffer.
+    memset(&totals, 0, sizeof(totals));
+    n = test_ingest_with_faults(2, 1, EBUSY, &totals, stats);
+    TEST_ASSERT_EQUAL(2, n);
+    TEST_ASSERT_EQUAL(0, totals.errors);
+
+    size_t nFailed = 0;
+    for (size_t i = 0; i < 3; i++) {
+        if (stats[i].result == STRSEPF_RESULT_OK) {
+            TEST_ASSERT_EQUAL(expected[i], totals.sum[i]);
+        } else {
+            TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_IO, stats[i].result);
+            TEST_ASSERT_EQUAL(EBUSY, stats[i].errnum);
+            TEST_ASSERT_EQUAL(7, stats[i].bytes); //< First read only
+            nFailed++;
+        }
+    }
+    TEST_ASSERT_EQUAL(1, nFailed);
+
+    // Submissions failing on every attempt: the last errno is reported
+    memset(&totals, 0, sizeof(totals));
+    n = test_ingest_with_faults(0, STRSEPF_INGEST_MAX_INFLIGHT * 8, EAGAIN, &totals, stats);
+    TEST_ASSERT_EQUAL(0, n);
+    for (size_t i = 0; i < 3; i++) {
+        TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_IO, stats[i].result);
+        TEST_ASSERT_EQUAL(EAGAIN, stats[i].errnum);
+    }
+}
+
+void
+test_strsepf_ingest_record_too_long()
+{
+    char file0[] = "/tmp/strsepf_ingest_XXXXXX";
+    test_ingest_write_file(file0, "v=1\nv=123456789\nv=2\n");
+
+    char const* const paths[] = { file0 };
+    char              buffers[8];
+    test_ingest_ctx   totals = { { 0 }, 0 };
+
+    strsepf_ingest_config const config = {
+        .buffers = buffers,
+        .bufferSize = 8,
+        .nInflight = 1,
+        .onRecord = test_ingest_on_record,
+        .ctx = &totals,
+    };
+    strsepf_ingest_stats stats[1];
+    int32_t              n = strsepf_ingest(&config, paths, 1, stats);
+    unlink(file0);
+
+    TEST_ASSERT_EQUAL(0, n);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_RECORD_TOO_LONG, stats[0].result);
+    TEST_ASSERT_EQUAL(1, totals.sum[0]);
+}
+
+//-----------------------------------------------------------
+//
+// Columnar tests
+//
+//-----------------------------------------------------------
+void
+test_strsepf_columns_split()
+{
+    char row0[] = "1,-2,3";
+    char row1[] = "4,5";
+    char row2[] = "7,8,9,10";
+    char row3[] = "11,,13";
+
+    char*          rows[] = { row0, row1, row2, row3 };
+    char*          fields[3 * 4];
+    strsepf_result errs[4];
+    size_t         n = strsepf_columns_split(rows, 4, ',', fields, 3, errs);
+
+    TEST_ASSERT_EQUAL(2, n);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_OK, errs[0]);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INPUT_DOESNT_MATCH_FORMAT, errs[1]);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INPUT_DOESNT_MATCH_FORMAT, errs[2]);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_OK, errs[3]);
+    TEST_ASSERT_EQUAL_STRING("-2", fields[1 * 4 + 0]);
+    TEST_ASSERT_EQUAL_STRING("", fields[1 * 4 + 3]);
+    TEST_ASSERT_NULL(fields[2 * 4 + 1]);
+
+    int32_t col1[4];
+    strsepf_column_to32(&fields[1 * 4], 4, col1, errs);
+    TEST_ASSERT_EQUAL(-2, col1[0]);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_OK, errs[0]);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_INPUT_DOESNT_MATCH_FORMAT, errs[1]); //< Kept
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_STRTOI_NOT_A_DECIMAL, errs[3]);
+}
+
+void
+test_strsepf_columns_same_as_scalar()
+{
+    // More than a block of rows, with every kind of fast path and fallback
+    static char const* const tokens[] = {
+        "0",           "7",         "-7",         "42",          "123456789", "-123456789",
+        "999999999",   "1000000000", "2147483647", "2147483648", "-2147483648", "-2147483649",
+        "4294967295",  "4294967296", "",           "-",           "12a",       "a12",
+        " 12",         "+12",       "007",        "-0",          "0x10",      "98765",
+        "1",           "22",        "333",        "4444",        "55555",     "666666",
+        "7777777",     "88888888",  "-1",         "923485709342875093248750923847509238475",
+    };
+    size_t const n = sizeof(tokens) / sizeof(tokens[0]);
+
+    char  storage[sizeof(tokens) / sizeof(tokens[0])][48];
+    char* column[sizeof(tokens) / sizeof(tokens[0])];
+    for (size_t i = 0; i < n; i++) {
+        strcpy(storage[i], tokens[i]);
+        column[i] = storage[i];
+    }
+
+    int32_t        signedValues[sizeof(tokens) / sizeof(tokens[0])];
+    uint32_t       unsignedValues[sizeof(tokens) / sizeof(tokens[0])];
+    strsepf_result signedErrs[sizeof(tokens) / sizeof(tokens[0])] = { STRSEPF_RESULT_OK };
+    strsepf_result unsignedErrs[sizeof(tokens) / sizeof(tokens[0])] = { STRSEPF_RESULT_OK };
+    strsepf_column_to32(column, n, signedValues, signedErrs);
+    strsepf_column_tou32(column, n, unsignedValues, unsignedErrs);
+
+    for (size_t i = 0; i < n; i++) {
+        strsepf_result err;
+        int32_t        expected = strto32_s(tokens[i], 10, &err);
+        TEST_ASSERT_EQUAL(err < STRSEPF_RESULT_OK ? err : STRSEPF_RESULT_OK, signedErrs[i]);
+        if (err == STRSEPF_RESULT_OK) {
+            TEST_ASSERT_EQUAL(expected, signedValues[i]);
+        }
+
+        uint32_t expectedU = strtou32_s(tokens[i], 10, &err);
+        TEST_ASSERT_EQUAL(err < STRSEPF_RESULT_OK ? err : STRSEPF_RESULT_OK, unsignedErrs[i]);
+        if (err == STRSEPF_RESULT_OK) {
+            TEST_ASSERT_EQUAL(expectedU, unsignedValues[i]);
+        }
+    }
+}
+
+//-----------------------------------------------------------
+//
+// SIMD kernel tests
+//
+//-----------------------------------------------------------
+void
+test_strsepf_simd_levels()
+{
+    for (int level = STRSEPF_SIMD_SCALAR; level <= STRSEPF_SIMD_AVX512; level++) {
+        TEST_ASSERT_TRUE(strsepf_simd_limit((strsepf_simd)level) <= (strsepf_simd)level);
+
+        // Tokens of every length, at every alignment of the vector blocks
+        for (size_t offset = 0; offset < 64; offset++) {
+            for (size_t len = 0; len < 100; len += 7) {
+                char buffer[256];
+                memset(buffer, 'a', sizeof(buffer));
+                char* test = &buffer[offset];
+                snprintf(&test[len], sizeof(buffer) - offset - len, ",%zu;tail", len);
+
+                char*    answer0 = NULL;
+                uint32_t answer1 = 0;
+                char*    answer2 = NULL;
+                int16_t  n = strsepf(test, "%s,%u;%s", &answer0, &answer1, &answer2);
+
+                TEST_ASSERT_EQUAL(3, n);
+                TEST_ASSERT_EQUAL(len, strlen(answer0));
+                TEST_ASSERT_EQUAL(len, answer1);
+                TEST_ASSERT_EQUAL_STRING("tail", answer2);
+            }
+        }
+
+        // Missing delimiter: the scan stops on the end of the string
+        char    test[] = "0123456789012345678901234567890123456789012345678901234567890123456789";
+        int32_t answer = 0;
+        TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_STRTOI_OUT_OF_RANGE, strsepf(test, "%d,", &answer));
+
+        // Conversion kernel
+        char tokens[][12] = { "0", "7", "-12", "999999999", "-999999999", "4294967295", "1x",
+                              "", "-", "123456789", "42" };
+        enum { nRows = sizeof(tokens) / sizeof(tokens[0]) };
+        char*          column[nRows];
+        int32_t        values[nRows];
+        strsepf_result errs[nRows] = { STRSEPF_RESULT_OK };
+        for (size_t i = 0; i < nRows; i++) {
+            column[i] = tokens[i];
+        }
+        strsepf_column_to32(column, nRows, values, errs);
+        for (size_t i = 0; i < nRows; i++) {
+            strsepf_result err;
+            int32_t        expected = strto32_s(tokens[i], 10, &err);
+            TEST_ASSERT_EQUAL(err < STRSEPF_RESULT_OK ? err : STRSEPF_RESULT_OK, errs[i]);
+            if (err == STRSEPF_RESULT_OK) {
+                TEST_ASSERT_EQUAL(expected, values[i]);
+            }
+        }
+    }
+
+    strsepf_simd_limit(STRSEPF_SIMD_AVX512);
+}
+
+//-----------------------------------------------------------
+//
+// Profiling tests (cmake -DSTRSEPF_PROFILE=ON)
+//
+//-----------------------------------------------------------
+#ifdef STRSEPF_PROFILE
+void
+test_strsepf_profile_stages()
+{
+    enum { nRecords = 1000 };
+
+    strsepf_profile_source const source = strsepf_profile_start();
+    TEST_ASSERT_NOT_EQUAL(STRSEPF_PROFILE_OFF, source);
+    for (size_t i = 0; i < nRecords; i++) {
+        char     test[] = "v=12345,pump";
+        uint32_t answer0 = 0;
+        char*    answer1 = NULL;
+        TEST_ASSERT_EQUAL(2, strsepf(test, "v=%u,%s", &answer0, &answer1));
+    }
+    strsepf_profile profile;
+    strsepf_profile_read(&profile);
+    strsepf_profile_stop();
+
+    // Every record enters each stage twice: `v` and `=`, then each of the 2 fields
+    uint64_t cycles = 0;
+    for (size_t s = 0; s < STRSEPF_STAGE_COUNT; s++) {
+        TEST_ASSERT_EQUAL(2 * nRecords, profile.stages[s].calls);
+        cycles += profile.stages[s].counters[STRSEPF_COUNTER_CYCLES];
+    }
+    TEST_ASSERT_TRUE(cycles > 0);
+    TEST_ASSERT_EQUAL(source, profile.source);
+
+    // Nothing is counted once stopped
+    char     test[] = "v=1,pump";
+    uint32_t answer0 = 0;
+    char*    answer1 = NULL;
+    strsepf(test, "v=%u,%s", &answer0, &answer1);
+    strsepf_profile_read(&profile);
+    TEST_ASSERT_EQUAL(STRSEPF_PROFILE_OFF, profile.source);
+    TEST_ASSERT_EQUAL(2 * nRecords, profile.stages[STRSEPF_STAGE_FORMAT].calls);
+}
+#endif
+
 //-----------------------------------------------------------
 //
 // Complex tests
@@ -421,6 +1856,70 @@ main(void)
     RUN_TEST(test_strsepf_subspecfier_with_too_big);
     RUN_TEST(test_strsepf_subspecfier_star);
 
+    // Predicate
+    RUN_TEST(test_strsepf_predicate_string_equal);
+    RUN_TEST(test_strsepf_predicate_rejects_before_next_fields);
+    RUN_TEST(test_strsepf_predicate_number_range);
+    RUN_TEST(test_strsepf_predicate_one_of);
+    RUN_TEST(test_strsepf_predicate_range_on_string);
+    RUN_TEST(test_strsepf_predicate_null_arg);
+
+    // Repeated group
+    RUN_TEST(test_strsepf_group_gpgsv);
+    RUN_TEST(test_strsepf_group_gpgsa_strings);
+    RUN_TEST(test_strsepf_group_until_end_of_input);
+    RUN_TEST(test_strsepf_group_last_delimiter_missing);
+    RUN_TEST(test_strsepf_group_more_than_capacity);
+    RUN_TEST(test_strsepf_group_incomplete_repetition);
+    RUN_TEST(test_strsepf_group_invalid_format);
+    RUN_TEST(test_strsepf_group_empty_list);
+
+    // Key/value
+    RUN_TEST(test_strsepf_kv_any_order);
+    RUN_TEST(test_strsepf_kv_reuse_compiled_format);
+    RUN_TEST(test_strsepf_kv_optional_specifiers);
+    RUN_TEST(test_strsepf_kv_conversion_error);
+    RUN_TEST(test_strsepf_kv_invalid_format);
+    RUN_TEST(test_strsepf_kv_many_keys);
+
+    // Arena
+    RUN_TEST(test_strsepf_copy_outlives_input);
+    RUN_TEST(test_strsepf_copy_arena_full);
+    RUN_TEST(test_strsepf_copy_group);
+
+    // Interning
+    RUN_TEST(test_strsepf_intern_repeated_strings);
+    RUN_TEST(test_strsepf_intern_full);
+    RUN_TEST(test_strsepf_intern_group_and_kv);
+
+    // Diagnostics
+    RUN_TEST(test_strsepf_diag_conversion_error);
+    RUN_TEST(test_strsepf_diag_literal_mismatch);
+    RUN_TEST(test_strsepf_diag_group);
+
+    // Pipeline
+    RUN_TEST(test_strsepf_ring_backpressure);
+    RUN_TEST(test_strsepf_reader_record_aligned);
+    RUN_TEST(test_strsepf_reader_record_too_long);
+    RUN_TEST(test_strsepf_reader_ring_sizes);
+    RUN_TEST(test_strsepf_pipeline_threads);
+    RUN_TEST(test_strsepf_pipeline_workers);
+
+    // Ingestion
+    RUN_TEST(test_strsepf_ingest_pread);
+    RUN_TEST(test_strsepf_ingest_io_uring);
+    RUN_TEST(test_strsepf_ingest_auto);
+    RUN_TEST(test_strsepf_ingest_io_uring_enter_failure);
+    RUN_TEST(test_strsepf_ingest_record_too_long);
+
+    // Columnar
+    RUN_TEST(test_strsepf_columns_split);
+    RUN_TEST(test_strsepf_columns_same_as_scalar);
+    RUN_TEST(test_strsepf_simd_levels);
+#ifdef STRSEPF_PROFILE
+    RUN_TEST(test_strsepf_profile_stages);
+#endif
+
     // Complex
     RUN_TEST(test_strsepf_ip_address);
     RUN_TEST(test_strsepf_commas_separeted_str);
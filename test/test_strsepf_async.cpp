@@ -0,0 +1,294 @@
+// C++ standard library
+#include <algorithm>   //< min
+#include <coroutine>   //< coroutine_handle
+#include <cstdint>     //< *int*_t
+#include <cstring>     //< memcpy
+#include <deque>       //< deque
+#include <span>        //< span
+#include <string>      //< string
+#include <string_view> //< string_view
+#include <vector>      //< vector
+
+// Unit tests framework
+// See : http://www.throwtheswitch.org/unity
+#include "unity.h"
+
+// Library under test
+#include "strsepf.hpp"
+#include "strsepf_pipeline.h" //< The C headers are also C++ headers
+
+//-----------------------------------------------------------
+//
+// Setup and teardown
+//
+//-----------------------------------------------------------
+void
+setUp(void)
+{}
+
+void
+tearDown(void)
+{}
+
+//-----------------------------------------------------------
+//
+// Test event loop
+//
+//-----------------------------------------------------------
+
+// Single thread event loop: resumes the suspended reads in order.
+static std::deque<std::coroutine_handle<>> ready;
+
+static void
+run_event_loop()
+{
+    while (!ready.empty()) {
+        std::coroutine_handle<> h = ready.front();
+        ready.pop_front();
+        h.resume();
+    }
+}
+
+// A slow stream: every read suspends, then delivers at most `chunk` bytes.
+struct slow_source
+{
+    std::string_view data;
+    std::size_t      chunk;
+
+    auto read(std::span<char> buffer)
+    {
+        struct awaiter
+        {
+            slow_source*    source;
+            std::span<char> buffer;
+
+            bool        await_ready() const noexcept { return false; }
+            void        await_suspend(std::coroutine_handle<> h) { ready.push_back(h); }
+            std::size_t await_resume()
+            {
+                std::size_t const n = std::min({ source->chunk, buffer.size(), source->data.size() });
+                source->data.copy(buffer.data(), n);
+                source->data.remove_prefix(n);
+                return n;
+            }
+        };
+        return awaiter{ this, buffer };
+    }
+};
+
+// Fire and forget coroutine running a consumer.
+struct detached
+{
+    struct promise_type
+    {
+        detached            get_return_object() { return {}; }
+        std::suspend_never  initial_suspend() noexcept { return {}; }
+        std::suspend_never  final_suspend() noexcept { return {}; }
+        void                return_void() {}
+        void                unhandled_exception() { std::terminate(); }
+    };
+};
+
+struct collected
+{
+    std::vector<int16_t>     results;
+    std::vector<uint32_t>    ids;
+    std::vector<std::string> names;
+    bool                     done = false;
+};
+
+static detached
+consume(slow_source& source, std::span<char> buffer, collected& out)
+{
+    auto gen = strsepf_async::records<uint32_t, std::string_view>(source, buffer, "%u,%s");
+    while (auto const* r = co_await gen.next()) {
+        out.results.push_back(r->result);
+        if (r->result == 2) {
+            auto const& [id, name] = r->fields;
+            out.ids.push_back(id);
+            out.names.emplace_back(name); //< Views are only valid until the next record
+        }
+    }
+    out.done = true;
+}
+
+//-----------------------------------------------------------
+//
+// Coroutine interface tests
+//
+//-----------------------------------------------------------
+void
+test_strsepf_records_split_reads()
+{
+    slow_source source{ "1,pump\n22,valve\nx,bad\n333,fan", 3 };
+    char        buffer[16];
+    collected   out;
+
+    consume(source, buffer, out);
+    TEST_ASSERT_FALSE(out.done); //< Suspended on the first read
+    run_event_loop();
+
+    TEST_ASSERT_TRUE(out.done);
+    TEST_ASSERT_EQUAL(4, out.results.size());
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_STRTOI_NOT_A_DECIMAL, out.results[2]);
+    TEST_ASSERT_EQUAL(3, out.ids.size());
+    TEST_ASSERT_EQUAL(1, out.ids[0]);
+    TEST_ASSERT_EQUAL(22, out.ids[1]);
+    TEST_ASSERT_EQUAL(333, out.ids[2]);
+    TEST_ASSERT_EQUAL_STRING("pump", out.names[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("valve", out.names[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("fan", out.names[2].c_str());
+}
+
+void
+test_strsepf_records_many_streams_one_thread()
+{
+    constexpr std::size_t nStreams = 100;
+    std::vector<std::string> inputs(nStreams);
+    std::vector<slow_source> sources;
+    std::vector<collected>   outs(nStreams);
+    std::vector<char>        buffers(nStreams * 32);
+    for (std::size_t i = 0; i < nStreams; i++) {
+        for (std::size_t j = 0; j < 10; j++) {
+            inputs[i] += std::to_string(i * 100 + j) + ",s" + std::to_string(i) + "\n";
+        }
+    }
+    for (std::size_t i = 0; i < nStreams; i++) {
+        sources.push_back(slow_source{ inputs[i], 1 + i % 7 });
+    }
+
+    // Streams interleave on the same thread
+    for (std::size_t i = 0; i < nStreams; i++) {
+        consume(sources[i], std::span<char>(&buffers[i * 32], 32), outs[i]);
+    }
+    run_event_loop();
+
+    for (std::size_t i = 0; i < nStreams; i++) {
+        std::string const name = "s" + std::to_string(i);
+        TEST_ASSERT_TRUE(outs[i].done);
+        TEST_ASSERT_EQUAL(10, outs[i].ids.size());
+        for (std::size_t j = 0; j < 10; j++) {
+            TEST_ASSERT_EQUAL(i * 100 + j, outs[i].ids[j]);
+            TEST_ASSERT_EQUAL_STRING(name.c_str(), outs[i].names[j].c_str());
+        }
+    }
+}
+
+void
+test_strsepf_records_too_long()
+{
+    slow_source source{ "1,ok\n2,this-record-is-too-long\n3,next\n", 64 };
+    char        buffer[16];
+    collected   out;
+
+    consume(source, buffer, out);
+    run_event_loop();
+
+    // Only the record longer than the buffer is dropped
+    TEST_ASSERT_TRUE(out.done);
+    TEST_ASSERT_EQUAL(3, out.results.size());
+    TEST_ASSERT_EQUAL(2, out.results[0]);
+    TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_RECORD_TOO_LONG, out.results[1]);
+    TEST_ASSERT_EQUAL(2, out.results[2]);
+    TEST_ASSERT_EQUAL_STRING("next", out.names[1].c_str());
+}
+
+static detached
+consume_numbers(slow_source& source, std::span<char> buffer, collected& out)
+{
+    auto gen = strsepf_async::records<uint32_t, uint32_t, int32_t>(source, buffer, "%u,%*s,%x,%d");
+    while (auto const* r = co_await gen.next()) {
+        auto const& [a, b, c] = r->fields;
+        out.results.push_back(r->result);
+        out.ids.push_back(a + b + static_cast<uint32_t>(c));
+    }
+    out.done = true;
+}
+
+void
+test_strsepf_records_same_as_strsepf()
+{
+    char const* const lines[] = { "1000000,text,ff,-3", "2,x,10", "3,y,zz,1", "4,z,1,2" };
+
+    for (std::size_t chunk = 1; chunk <= 5; chunk++) {
+        slow_source source{ "1000000,text,ff,-3\n"
+                            "5,a-record-longer-than-the-buffer,1,1\n"
+                            "2,x,10\n"
+                            "3,y,zz,1\n"
+                            "4,z,1,2",
+                            chunk };
+        char        buffer[20];
+        collected   out;
+
+        consume_numbers(source, buffer, out);
+        run_event_loop();
+
+        TEST_ASSERT_TRUE(out.done);
+        TEST_ASSERT_EQUAL(5, out.results.size());
+        TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_RECORD_TOO_LONG, out.results[1]);
+        out.results.erase(out.results.begin() + 1);
+        out.ids.erase(out.ids.begin() + 1);
+
+        // Every other record is parsed by `strsepf`
+        for (std::size_t i = 0; i < 4; i++) {
+            std::string line = lines[i];
+            uint32_t    a = 0;
+            uint32_t    b = 0;
+            int32_t     c = 0;
+            int16_t     n = strsepf(line.data(), "%u,%*s,%x,%d", &a, &b, &c);
+            TEST_ASSERT_EQUAL(n, out.results[i]);
+            TEST_ASSERT_EQUAL(a + b + static_cast<uint32_t>(c), out.ids[i]);
+        }
+        TEST_ASSERT_EQUAL(3, out.results[0]);
+        TEST_ASSERT_EQUAL(STRSEPF_RESULT_ERR_STRTOI_NOT_A_DECIMAL, out.results[2]);
+    }
+}
+
+//-----------------------------------------------------------
+//
+// C interface from C++
+//
+//-----------------------------------------------------------
+void
+test_strsepf_pipeline_rings_from_cpp()
+{
+    // An array of rings has the layout of the C library
+    char          storage[2][2 * 16];
+    strsepf_batch batches[2][2];
+    strsepf_ring  rings[2];
+    for (std::size_t i = 0; i < 2; i++) {
+        TEST_ASSERT_EQUAL(STRSEPF_RESULT_OK, strsepf_ring_init(&rings[i], storage[i], 16, batches[i], 2));
+    }
+
+    char* slot = strsepf_ring_acquire(&rings[1]);
+    TEST_ASSERT_NOT_NULL(slot);
+    std::memcpy(slot, "1,pump", 7);
+    strsepf_ring_publish(&rings[1], 6, 42);
+
+    TEST_ASSERT_NULL(strsepf_ring_peek(&rings[0]));
+    strsepf_batch* batch = strsepf_ring_peek(&rings[1]);
+    TEST_ASSERT_NOT_NULL(batch);
+    TEST_ASSERT_EQUAL(42, batch->seq);
+    TEST_ASSERT_EQUAL_STRING("1,pump", batch->data);
+    strsepf_ring_release(&rings[1]);
+    TEST_ASSERT_NULL(strsepf_ring_peek(&rings[1]));
+}
+
+//-----------------------------------------------------------
+//
+// Test bench
+//
+//-----------------------------------------------------------
+int
+main(void)
+{
+    UNITY_BEGIN();
+
+    RUN_TEST(test_strsepf_records_split_reads);
+    RUN_TEST(test_strsepf_records_many_streams_one_thread);
+    RUN_TEST(test_strsepf_records_too_long);
+    RUN_TEST(test_strsepf_records_same_as_strsepf);
+    RUN_TEST(test_strsepf_pipeline_rings_from_cpp);
+
+    return UNITY_END();
+}
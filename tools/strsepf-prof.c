@@ -0,0 +1,283 @@
+/* +------------------------------------------------------+
+ * | strsepf-prof.c                                       |
+ * | Runs a format over every line of a file and prints   |
+ * | where the parser spends its time, stage by stage.    |
+ * |                                                      |
+ * +------------------------------------------------------+
+ * |                                        G. Berthiaume |
+ * |                                          MIT licence |
+ * |                                                 2019 |
+ * +------------------------------------------------------+
+ */
+
+// Usage: strsepf-prof [-n repeat] <format> <file>
+//
+// eg - strsepf-prof -n 100 '$GPGGA,%*d.%*d,%d.%d,%s,%d.%d,%s,%*d,%u' nmea.log
+//
+// The `?` and `%k` specifiers aren't supported: they need caller objects.
+
+//-------------------------------------------//
+//                                           //
+//                Includes                   //
+//                                           //
+//-------------------------------------------//
+#include <ctype.h>   //< cstdlib : isdigit
+#include <stdbool.h> //< cstdlib : bool
+#include <stdint.h>  //< cstdlib : *int*_t
+#include <stdio.h>   //< cstdlib : fopen, fread, printf
+#include <stdlib.h>  //< cstdlib : malloc, strtoul
+#include <string.h>  //< cstdlib : memchr, memcpy, strcmp
+
+#include "strsepf.h"
+#include "strsepf_profile.h"
+
+//-------------------------------------------//
+//                                           //
+//          Internal definitions             //
+//                                           //
+//-------------------------------------------//
+
+// Maximum number of arguments of the format.
+#define PROF_MAX_ARGS 32
+
+// Maximum capacity of a repeated group.
+#define PROF_MAX_GROUP 1024
+
+// Output of every argument: large enough for a group array of any field type.
+typedef union
+{
+    size_t   repetitions;
+    char*    strs[PROF_MAX_GROUP];
+    uint32_t u32s[PROF_MAX_GROUP];
+    int32_t  i32s[PROF_MAX_GROUP];
+} prof_output;
+
+static char const* const stageNames[STRSEPF_STAGE_COUNT] = {
+    [STRSEPF_STAGE_FORMAT] = "format",   [STRSEPF_STAGE_LITERAL] = "literal",
+    [STRSEPF_STAGE_SCAN] = "scan",       [STRSEPF_STAGE_WIDTH] = "width",
+    [STRSEPF_STAGE_CONVERT] = "convert", [STRSEPF_STAGE_STORE] = "store",
+};
+
+static char const* const sourceNames[] = {
+    [STRSEPF_PROFILE_OFF] = "off",
+    [STRSEPF_PROFILE_PERF_RDPMC] = "perf_event_open (rdpmc)",
+    [STRSEPF_PROFILE_PERF_READ] = "perf_event_open (read)",
+    [STRSEPF_PROFILE_TSC] = "time stamp counter (no perf_event_open)",
+    [STRSEPF_PROFILE_CLOCK] = "monotonic clock, ns (no perf_event_open)",
+};
+
+//-------------------------------------------//
+//                                           //
+//        Internal function definitions      //
+//                                           //
+//-------------------------------------------//
+
+/*
+ * Count the arguments of a format and reject what the tool can't provide.
+ *
+ * RETURNS:
+ *  The number of arguments, or -1 with a message.
+ */
+static int
+prof_count_args(char const* fmt)
+{
+    int nArgs = 0;
+    for (char const* f = fmt; *f != '\0'; f++) {
+        if (*f == '}') {
+            if (strtoul(f + 1, NULL, 10) > PROF_MAX_GROUP) {
+                fprintf(stderr, "strsepf-prof: group capacity larger than %d\n", PROF_MAX_GROUP);
+                return -1;
+            }
+            continue;
+        }
+        if (*f != '%') {
+            continue;
+        }
+        f++;
+        if (*f == '%') {
+            continue;
+        }
+        if (*f == '{') {
+            nArgs++; //< Number of repetitions
+            continue;
+        }
+
+        int noAssign = 0;
+        for (; *f == '*' || *f == '?' || isdigit((unsigned char)*f); f++) {
+            if (*f == '?') {
+                fprintf(stderr, "strsepf-prof: the '?' specifier isn't supported\n");
+                return -1;
+            }
+            noAssign = noAssign || *f == '*';
+        }
+        if (*f == 'k') {
+            fprintf(stderr, "strsepf-prof: the %%k specifier isn't supported\n");
+            return -1;
+        }
+        if (*f == '\0') {
+            break;
+        }
+        nArgs += !noAssign;
+    }
+    if (nArgs > PROF_MAX_ARGS) {
+        fprintf(stderr, "strsepf-prof: more than %d arguments\n", PROF_MAX_ARGS);
+        return -1;
+    }
+    return nArgs;
+}
+
+static char*
+prof_read_file(char const* path, size_t* size)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return NULL;
+    }
+
+    char*  data = NULL;
+    size_t cap = 0;
+    *size = 0;
+    for (;;) {
+        if (*size == cap) {
+            cap = (cap == 0) ? 1 << 16 : 2 * cap;
+            char* grown = realloc(data, cap);
+            if (grown == NULL) {
+                perror(path);
+                free(data);
+                fclose(file);
+                return NULL;
+            }
+            data = grown;
+        }
+        size_t const n = fread(data + *size, 1, cap - *size, file);
+        if (n == 0) {
+            break;
+        }
+        *size += n;
+    }
+    fclose(file);
+    return data;
+}
+
+static void
+prof_usage(void)
+{
+    fprintf(stderr, "usage: strsepf-prof [-n repeat] <format> <file>\n");
+}
+
+//-------------------------------------------//
+//                                           //
+//                  Main                     //
+//                                           //
+//-------------------------------------------//
+
+int
+main(int argc, char* argv[])
+{
+    unsigned long repeat = 1;
+    int           argi = 1;
+    if (argi + 1 < argc && strcmp(argv[argi], "-n") == 0) {
+        repeat = strtoul(argv[argi + 1], NULL, 10);
+        argi += 2;
+    }
+    if (argc - argi != 2 || repeat == 0) {
+        prof_usage();
+        return 2;
+    }
+    char const* fmt = argv[argi];
+    char const* path = argv[argi + 1];
+
+    int const nArgs = prof_count_args(fmt);
+    if (nArgs < 0) {
+        return 2;
+    }
+
+    size_t size;
+    char*  data = prof_read_file(path, &size);
+    if (data == NULL) {
+        return 1;
+    }
+
+    // Longest record: every record is copied there before parsing, as `strsepf`
+    // modifies its input.
+    size_t maxLen = 0;
+    for (char const *line = data, *end = data + size; line < end;) {
+        char const* nl = memchr(line, '\n', (size_t)(end - line));
+        size_t const len = (size_t)((nl != NULL ? nl : end) - line);
+        maxLen = (len > maxLen) ? len : maxLen;
+        line += len + 1;
+    }
+
+    char*        record = malloc(maxLen + 1);
+    prof_output* outputs = calloc(PROF_MAX_ARGS, sizeof(prof_output));
+    if (record == NULL || outputs == NULL) {
+        perror("strsepf-prof");
+        return 1;
+    }
+    void* args[PROF_MAX_ARGS];
+    for (size_t i = 0; i < PROF_MAX_ARGS; i++) {
+        args[i] = &outputs[i];
+    }
+
+    strsepf_profile_source const source = strsepf_profile_start();
+    uint64_t                     nRecords = 0;
+    uint64_t                     nErrors = 0;
+    for (unsigned long r = 0; r < repeat; r++) {
+        for (char const *line = data, *end = data + size; line < end;) {
+            char const*  nl = memchr(line, '\n', (size_t)(end - line));
+            size_t const len = (size_t)((nl != NULL ? nl : end) - line);
+            memcpy(record, line, len);
+            record[len] = '\0';
+            line += len + 1;
+
+            int16_t const rc = strsepf(record, fmt, args[0], args[1], args[2], args[3], args[4], args[5],
+                                       args[6], args[7], args[8], args[9], args[10], args[11], args[12],
+                                       args[13], args[14], args[15], args[16], args[17], args[18], args[19],
+                                       args[20], args[21], args[22], args[23], args[24], args[25], args[26],
+                                       args[27], args[28], args[29], args[30], args[31]);
+            nRecords++;
+            nErrors += (rc < 0);
+        }
+    }
+    strsepf_profile profile;
+    strsepf_profile_read(&profile);
+    strsepf_profile_stop();
+
+    // Report
+    uint64_t total = 0;
+    for (size_t s = 0; s < STRSEPF_STAGE_COUNT; s++) {
+        total += profile.stages[s].counters[STRSEPF_COUNTER_CYCLES];
+    }
+    bool const perf = (source == STRSEPF_PROFILE_PERF_RDPMC || source == STRSEPF_PROFILE_PERF_READ);
+
+    printf("format:   %s\n", fmt);
+    printf("records:  %llu (%llu errors), %d arguments\n", (unsigned long long)nRecords,
+           (unsigned long long)nErrors, nArgs);
+    printf("counters: %s\n\n", sourceNames[source]);
+    printf("%-8s %12s %14s %6s %10s", "stage", "calls", "cycles", "%", "cyc/call");
+    if (perf) {
+        printf(" %14s %14s", "branch-misses", "cache-misses");
+    }
+    printf("\n");
+    for (size_t s = 0; s < STRSEPF_STAGE_COUNT; s++) {
+        strsepf_stage_profile const* stage = &profile.stages[s];
+        uint64_t const               cycles = stage->counters[STRSEPF_COUNTER_CYCLES];
+        printf("%-8s %12llu %14llu %5.1f%% %10.1f", stageNames[s], (unsigned long long)stage->calls,
+               (unsigned long long)cycles, total ? 100.0 * (double)cycles / (double)total : 0.0,
+               stage->calls ? (double)cycles / (double)stage->calls : 0.0);
+        if (perf) {
+            printf(" %14llu %14llu", (unsigned long long)stage->counters[STRSEPF_COUNTER_BRANCH_MISSES],
+                   (unsigned long long)stage->counters[STRSEPF_COUNTER_CACHE_MISSES]);
+        }
+        printf("\n");
+    }
+    printf("%-8s %12s %14llu %5.1f%% %10.1f\n", "total", "", (unsigned long long)total, 100.0,
+           nRecords ? (double)total / (double)nRecords : 0.0);
+    printf("(cyc/call of total: per record)\n");
+
+    free(outputs);
+    free(record);
+    free(data);
+    return (nErrors == nRecords && nRecords > 0) ? 1 : 0;
+}